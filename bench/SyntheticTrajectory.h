@@ -0,0 +1,31 @@
+// bench/SyntheticTrajectory.h
+#ifndef SYNTHETICTRAJECTORY_H
+#define SYNTHETICTRAJECTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Generador de trayectorias sintéticas con el formato de entrada de
+// bop-rdf: pares frame_XXX.xyz / frame_XXX_bop.xyz en un directorio. La
+// proteína es un glóbulo compacto en el centro de la caja (densidad de
+// átomos de proteína, mezcla de C, N, O, S e H) rodeado de aguas a la
+// densidad del agua líquida. Entre frames los átomos se desplazan un poco
+// (más las aguas que la proteína), como en frames consecutivos de MD.
+struct SyntheticTrajectory {
+    size_t frames = 20;
+    size_t proteinAtoms = 5000;
+    size_t waters = 20000;
+    double proteinStep = 0.05;   // Desplazamiento típico por frame (Å)
+    double waterStep = 0.3;
+    uint64_t seed = 1;
+
+    // Lado de la caja cúbica que da la densidad del agua con esta cantidad
+    // de aguas más el volumen de la proteína
+    double boxSize() const;
+
+    // Escribe los frames en directory (lo crea si no existe)
+    void write(const std::string& directory) const;
+};
+
+#endif
@@ -0,0 +1,489 @@
+// bench/bopBench.cpp
+// Benchmarks de bop-rdf: parser, núcleo de distancias, grilla de celdas,
+// histograma con varios hilos y procesamiento completo de un directorio,
+// más la comparación de la búsqueda en float contra la de double y la
+// lectura de aguas con distintas líneas de comentario.
+// Cada resultado es una línea JSON en la salida estándar, para seguirlos
+// en el tiempo.
+#include "SyntheticTrajectory.h"
+#include "ProteinWaterAnalyzer.h"
+#include "CellList.h"
+#include "DistanceKernel.h"
+#include "Histogram1D.h"
+#include "MappedFile.h"
+#include "TrajectoryReader.h"
+#include "XyzParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+
+namespace {
+
+struct Options {
+    std::string directory;
+    SyntheticTrajectory trajectory;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int repeat = 3;
+    std::string only;            // Vacío: todos
+};
+
+// Descarta lo que el analizador escribe en std::cout
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+std::ostream results(std::cout.rdbuf());
+
+bool selected(const Options& options, const std::string& name) {
+    if (options.only.empty()) {
+        return true;
+    }
+    std::istringstream stream(options.only);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Mejor tiempo (s) de repeat ejecuciones de run
+template <class F>
+double bestOf(int repeat, F&& run) {
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repeat; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+void report(const std::string& name, const Options& options, int threads, double seconds,
+            std::initializer_list<std::pair<const char*, double>> rates) {
+    results << "{\"benchmark\":\"" << name << "\""
+            << ",\"kernel\":\"" << distanceKernelName() << "\""
+            << ",\"threads\":" << threads
+            << ",\"frames\":" << options.trajectory.frames
+            << ",\"atoms\":" << options.trajectory.proteinAtoms
+            << ",\"waters\":" << options.trajectory.waters
+            << ",\"seconds\":" << seconds;
+    for (const auto& [key, value] : rates) {
+        results << ",\"" << key << "\":" << value;
+    }
+    results << "}" << std::endl;
+}
+
+std::string framePath(const Options& options, size_t frame, bool water) {
+    return options.directory + "/frame_" + std::to_string(frame) + (water ? "_bop.xyz" : ".xyz");
+}
+
+// Igual que ProteinWaterAnalyzer::readProteinFile/readWaterFile
+void benchParse(const Options& options) {
+    const size_t frames = options.trajectory.frames;
+    for (bool water : {false, true}) {
+        FrameData frame(0);
+        size_t bytes = 0;
+        double seconds = bestOf(options.repeat, [&]() {
+            bytes = 0;
+            for (size_t f = 0; f < frames; ++f) {
+                const std::string path = framePath(options, f, water);
+                MappedFile file(path);
+                XyzParser parser(file.begin(), file.end(), path);
+                if (water) {
+                    parser.parseWaterFrame(frame, ElementMask::all());
+                } else {
+                    parser.parseProteinFrame(frame, ElementMask::all());
+                }
+                bytes += file.size();
+            }
+        });
+        const double records = static_cast<double>(frames) *
+            (water ? options.trajectory.waters : options.trajectory.proteinAtoms);
+        report(water ? "parse_water" : "parse_protein", options, 1, seconds,
+               {{"frames_per_s", frames / seconds},
+                {"records_per_s", records / seconds},
+                {"mb_per_s", bytes / seconds / 1e6}});
+    }
+}
+
+FrameData loadFrame(const Options& options, size_t index = 0) {
+    FrameData frame(0);
+    const std::string proteinPath = framePath(options, index, false);
+    const std::string waterPath = framePath(options, index, true);
+    MappedFile proteinFile(proteinPath);
+    XyzParser(proteinFile.begin(), proteinFile.end(), proteinPath).parseProteinFrame(frame);
+    MappedFile waterFile(waterPath);
+    XyzParser(waterFile.begin(), waterFile.end(), waterPath).parseWaterFrame(frame);
+    return frame;
+}
+
+// Coordenadas de la proteína en precisión Real
+template <typename Real>
+struct AtomsOf {
+    std::vector<Real> x, y, z;
+
+    explicit AtomsOf(const ProteinAtoms& atoms)
+        : x(atoms.x.begin(), atoms.x.end()), y(atoms.y.begin(), atoms.y.end()),
+          z(atoms.z.begin(), atoms.z.end()) {}
+};
+
+// Búsqueda por fuerza bruta de un frame, como calculateMinDistances, con
+// la caja del frame o con otra (para medir el costo de cada imagen mínima)
+template <typename Real>
+void benchKernel(const Options& options, const FrameData& frame, const char* name,
+                 const PeriodicBox& box) {
+    const AtomsOf<Real> atoms(frame.proteinAtoms);
+    const WaterMolecules& source = frame.waterMolecules;
+    const std::vector<Real> wx(source.x.begin(), source.x.end());
+    const std::vector<Real> wy(source.y.begin(), source.y.end());
+    const std::vector<Real> wz(source.z.begin(), source.z.end());
+    std::vector<Real> minDist2(wx.size());
+    double seconds = bestOf(options.repeat, [&]() {
+        std::fill(minDist2.begin(), minDist2.end(), std::numeric_limits<Real>::max());
+        distanceKernel<Real>(box.kind)(atoms.x.data(), atoms.y.data(), atoms.z.data(), atoms.x.size(),
+                                       wx.data(), wy.data(), wz.data(), wx.size(), box, minDist2.data());
+    });
+    const double pairs = static_cast<double>(atoms.x.size()) * wx.size();
+    report(name, options, 1, seconds,
+           {{"frames_per_s", 1.0 / seconds}, {"atom_pairs_per_s", pairs / seconds}});
+}
+
+// Grilla de celdas de un frame (construcción y búsqueda)
+template <typename Real>
+void benchCells(const Options& options, const FrameData& frame, const char* name) {
+    const ProteinAtoms& atoms = frame.proteinAtoms;
+    const WaterMolecules& waters = frame.waterMolecules;
+    PeriodicBox box(frame.Lx, frame.Ly, frame.Lz, frame.xy, frame.xz, frame.yz);
+    std::vector<double> minDist(waters.size());
+    double seconds = bestOf(options.repeat, [&]() {
+        CellList<Real> cells(atoms.positions(), box, 4.0);
+        cells.findMinDistances(waters.x.data(), waters.y.data(), waters.z.data(), waters.size(),
+                               20.0, minDist.data());
+    });
+    // Pares equivalentes: los que recorrería la fuerza bruta
+    const double pairs = static_cast<double>(atoms.size()) * waters.size();
+    report(name, options, 1, seconds,
+           {{"frames_per_s", 1.0 / seconds},
+            {"waters_per_s", waters.size() / seconds},
+            {"atom_pairs_per_s", pairs / seconds}});
+}
+
+// Exactitud de -precision float: en todos los frames, distancias de la
+// grilla en float contra la fuerza bruta en double, y bins del histograma
+// por defecto (100 bins en [0, 20]) que cambian. Un agua sólo puede cambiar
+// de bin si su distancia está a menos del error máximo de un borde.
+void benchPrecision(const Options& options) {
+    constexpr double minDistance = 0.0, maxDistance = 20.0;
+    constexpr int bins = 100;
+    const double binWidth = (maxDistance - minDistance) / bins;
+    // Igual que Histogram1D::binIndex
+    auto binIndex = [&](double distance) {
+        if (!(distance >= minDistance && distance <= maxDistance)) {
+            return -1;
+        }
+        return std::min(static_cast<int>((distance - minDistance) / binWidth), bins - 1);
+    };
+
+    double maxError = 0.0, maxEdgeDistance = 0.0, seconds = 0.0;
+    size_t samples = 0, mismatches = 0;
+    std::vector<double> reference, single;
+    for (size_t f = 0; f < options.trajectory.frames; ++f) {
+        const FrameData frame = loadFrame(options, f);
+        const ProteinAtoms& atoms = frame.proteinAtoms;
+        const WaterMolecules& waters = frame.waterMolecules;
+        PeriodicBox box(frame.Lx, frame.Ly, frame.Lz, frame.xy, frame.xz, frame.yz);
+        reference.assign(waters.size(), std::numeric_limits<double>::max());
+        distanceKernel<double>(box.kind)(atoms.x.data(), atoms.y.data(), atoms.z.data(), atoms.size(),
+                                         waters.x.data(), waters.y.data(), waters.z.data(), waters.size(),
+                                         box, reference.data());
+        single.resize(waters.size());
+        seconds += bestOf(1, [&]() {
+            CellList<float> cells(atoms.positions(), box, 4.0);
+            cells.findMinDistances(waters.x.data(), waters.y.data(), waters.z.data(), waters.size(),
+                                   maxDistance, single.data());
+        });
+
+        for (size_t w = 0; w < waters.size(); ++w) {
+            const double exact = std::sqrt(reference[w]);
+            if (exact > maxDistance) {
+                continue;
+            }
+            ++samples;
+            maxError = std::max(maxError, std::abs(single[w] - exact));
+            const int bin = binIndex(exact);
+            if (binIndex(single[w]) != bin) {
+                ++mismatches;
+                const double lower = minDistance + bin * binWidth;
+                maxEdgeDistance = std::max(maxEdgeDistance,
+                                           std::min(exact - lower, lower + binWidth - exact));
+            }
+        }
+    }
+    report("precision_float", options, 1, seconds,
+           {{"samples", static_cast<double>(samples)},
+            {"max_abs_error", maxError},
+            {"bin_mismatches", static_cast<double>(mismatches)},
+            {"mismatch_fraction", samples > 0 ? static_cast<double>(mismatches) / samples : 0.0},
+            {"max_mismatch_edge_distance", maxEdgeDistance}});
+}
+
+// Exactitud de la lectura de aguas según la línea de comentario: las aguas
+// del frame 0 se reescriben sin comentario, con frame=, con una celda
+// Lattice= (nueve números después del elemento aparente) y con texto
+// libre, una vez (para XyzParser, como en el directorio) y dos veces en
+// un mismo archivo (para TrajectoryReader); ninguna molécula debe faltar,
+// sobrar ni cambiar.
+void benchComments(const Options& options) {
+    const FrameData original = loadFrame(options);
+    const WaterMolecules& expected = original.waterMolecules;
+    const double L = original.Lx;
+    char lattice[160];
+    std::snprintf(lattice, sizeof(lattice), "Lattice=\"%.1f 0 0 %.1f %.1f 0 %.1f %.1f %.1f\" pbc=\"T T T\"",
+                  L, 0.25 * L, L, -0.2 * L, 0.15 * L, L);
+    const std::pair<const char*, std::string> comments[] = {
+        {"none", ""}, {"frame", "frame=0"}, {"lattice", lattice}, {"text", "Generado por bop-bench"}};
+
+    auto mismatches = [&](const WaterMolecules& waters) {
+        size_t count = waters.size() > expected.size() ? waters.size() - expected.size()
+                                                       : expected.size() - waters.size();
+        for (size_t i = 0; i < std::min(waters.size(), expected.size()); ++i) {
+            if (waters.x[i] != expected.x[i] || waters.y[i] != expected.y[i] ||
+                waters.z[i] != expected.z[i] || waters.Q6[i] != expected.Q6[i]) {
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    const std::string framePath = options.directory + "/comments_bop.xyz";
+    const std::string trajectoryPath = options.directory + "/comments_trajectory_bop.xyz";
+    for (const auto& [name, comment] : comments) {
+        for (int copies : {1, 2}) {
+            const std::string& path = copies == 1 ? framePath : trajectoryPath;
+            std::unique_ptr<FILE, int (*)(FILE*)> out(std::fopen(path.c_str(), "w"), std::fclose);
+            if (!out) {
+                throw std::runtime_error("No se pudo crear el archivo: " + path);
+            }
+            for (int copy = 0; copy < copies; ++copy) {
+                std::fprintf(out.get(), "%zu\n", expected.size());
+                if (!comment.empty()) {
+                    std::fprintf(out.get(), "%s\n", comment.c_str());
+                }
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    std::fprintf(out.get(), "O %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n",
+                                 expected.x[i], expected.y[i], expected.z[i], expected.Q4[i],
+                                 expected.Q6[i], expected.W4[i], expected.W6[i]);
+                }
+            }
+        }
+
+        FrameData frame(0);
+        size_t parserErrors = 0, readerErrors = 0, framesRead = 0;
+        const double seconds = bestOf(1, [&]() {
+            MappedFile file(framePath);
+            XyzParser(file.begin(), file.end(), framePath).parseWaterFrame(frame);
+            parserErrors = mismatches(frame.waterMolecules);
+            TrajectoryReader reader(trajectoryPath, TrajectoryReader::Kind::Water);
+            while (reader.readFrame(frame)) {
+                ++framesRead;
+                readerErrors += mismatches(frame.waterMolecules);
+            }
+        });
+        report(std::string("water_comment_") + name, options, 1, seconds,
+               {{"molecules", static_cast<double>(expected.size())},
+                {"parser_mismatches", static_cast<double>(parserErrors)},
+                {"trajectory_frames", static_cast<double>(framesRead)},
+                {"trajectory_mismatches", static_cast<double>(readerErrors)}});
+    }
+    std::filesystem::remove(framePath);
+    std::filesystem::remove(trajectoryPath);
+}
+
+// Histogram1D::addDataPoint con 1, 2, 4, ... hilos, cada uno en su shard
+void benchHistogram(const Options& options) {
+    constexpr size_t samplesPerThread = 1 << 22;
+    std::vector<double> distances(samplesPerThread), parameters(samplesPerThread);
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < samplesPerThread; ++i) {
+        distances[i] = 20.0 * uniform(rng);
+        parameters[i] = uniform(rng);
+    }
+
+    for (int threads = 1; ; threads = std::min(2 * threads, options.threads)) {
+        Histogram1D histogram(0.0, 20.0, 100, threads);
+        double seconds = bestOf(options.repeat, [&]() {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    for (size_t i = 0; i < samplesPerThread; ++i) {
+                        histogram.addDataPoint(distances[i], parameters[i], t);
+                    }
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        });
+        const double samples = static_cast<double>(samplesPerThread) * threads;
+        report("histogram_add", options, threads, seconds, {{"samples_per_s", samples / seconds}});
+        if (threads == options.threads) {
+            break;
+        }
+    }
+}
+
+// processDirectory completo, sin caché
+void benchEndToEnd(const Options& options) {
+    NullBuffer null;
+    double seconds = bestOf(options.repeat, [&]() {
+        std::streambuf* previous = std::cout.rdbuf(&null);
+        ProteinWaterAnalyzer analyzer(options.threads, 0.0, 20.0, 100, {2});
+        analyzer.setProgressInterval(0);
+        analyzer.processDirectory(options.directory, "");
+        analyzer.wait();
+        std::cout.rdbuf(previous);
+    });
+    const double frames = static_cast<double>(options.trajectory.frames);
+    const double pairs = frames * options.trajectory.proteinAtoms * options.trajectory.waters;
+    report("process_directory", options, options.threads, seconds,
+           {{"frames_per_s", frames / seconds}, {"atom_pairs_per_s", pairs / seconds}});
+}
+
+void showUsage(const char* programName) {
+    std::cout << "Uso: " << programName << " [opciones]" << std::endl;
+    std::cout << "     " << programName << " generate <directorio> [opciones de tamaño]" << std::endl;
+    std::cout << "Opciones:" << std::endl;
+    std::cout << "  -dir <directorio> Trayectoria a usar; se genera si no tiene frames" << std::endl;
+    std::cout << "                 (por defecto: <tmp>/bop-bench-<frames>-<átomos>-<aguas>)" << std::endl;
+    std::cout << "  -frames <número> Frames de la trayectoria sintética (por defecto: 20)" << std::endl;
+    std::cout << "  -atoms <número> Átomos de proteína por frame (por defecto: 5000)" << std::endl;
+    std::cout << "  -waters <número> Aguas por frame (por defecto: 20000)" << std::endl;
+    std::cout << "  -seed <número> Semilla del generador (por defecto: 1)" << std::endl;
+    std::cout << "  -t <número>    Hilos (por defecto: CPUs disponibles)" << std::endl;
+    std::cout << "  -repeat <número> Repeticiones; se informa la mejor (por defecto: 3)" << std::endl;
+    std::cout << "  -only <lista>  Sólo estos benchmarks: parse, brute, cells, histogram, e2e," << std::endl;
+    std::cout << "                 precision, comments" << std::endl;
+    std::cout << "  -kernel <nombre> Núcleo de distancias: auto, scalar, avx2, avx512" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Cada resultado es una línea JSON con el benchmark, la configuración y" << std::endl;
+    std::cout << "los rendimientos (frames_per_s, atom_pairs_per_s, ...)." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        Options options;
+        int firstOption = 1;
+        bool generateOnly = argc > 1 && std::string(argv[1]) == "generate";
+        if (generateOnly) {
+            if (argc < 3) {
+                showUsage(argv[0]);
+                return 1;
+            }
+            options.directory = argv[2];
+            firstOption = 3;
+        }
+
+        for (int i = firstOption; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "-dir" && i + 1 < argc) {
+                options.directory = argv[++i];
+            } else if (arg == "-frames" && i + 1 < argc) {
+                options.trajectory.frames = std::stoul(argv[++i]);
+            } else if (arg == "-atoms" && i + 1 < argc) {
+                options.trajectory.proteinAtoms = std::stoul(argv[++i]);
+            } else if (arg == "-waters" && i + 1 < argc) {
+                options.trajectory.waters = std::stoul(argv[++i]);
+            } else if (arg == "-seed" && i + 1 < argc) {
+                options.trajectory.seed = std::stoull(argv[++i]);
+            } else if (arg == "-t" && i + 1 < argc) {
+                options.threads = std::stoi(argv[++i]);
+            } else if (arg == "-repeat" && i + 1 < argc) {
+                options.repeat = std::stoi(argv[++i]);
+            } else if (arg == "-only" && i + 1 < argc) {
+                options.only = argv[++i];
+            } else if (arg == "-kernel" && i + 1 < argc) {
+                selectDistanceKernel(argv[++i]);
+            } else if (arg == "-h" || arg == "--help") {
+                showUsage(argv[0]);
+                return 0;
+            }
+        }
+
+        if (options.threads < 1 || options.repeat < 1 || options.trajectory.frames < 1 ||
+            options.trajectory.proteinAtoms < 1 || options.trajectory.waters < 1) {
+            std::cerr << "Error: Los hilos, las repeticiones y los tamaños deben ser al menos 1" << std::endl;
+            return 1;
+        }
+
+        if (options.directory.empty()) {
+            options.directory = (std::filesystem::temp_directory_path() /
+                ("bop-bench-" + std::to_string(options.trajectory.frames) + "-" +
+                 std::to_string(options.trajectory.proteinAtoms) + "-" +
+                 std::to_string(options.trajectory.waters))).string();
+        }
+
+        // La trayectoria se genera una sola vez y se reutiliza
+        const std::string lastFrame = framePath(options, options.trajectory.frames - 1, true);
+        if (generateOnly || !std::filesystem::exists(lastFrame)) {
+            std::cerr << "Generando " << options.trajectory.frames << " frames en "
+                      << options.directory << std::endl;
+            options.trajectory.write(options.directory);
+        }
+        if (generateOnly) {
+            return 0;
+        }
+
+        if (selected(options, "parse")) {
+            benchParse(options);
+        }
+        if (selected(options, "brute") || selected(options, "cells")) {
+            FrameData frame = loadFrame(options);
+            if (selected(options, "brute")) {
+                const PeriodicBox box(frame.Lx, frame.Ly, frame.Lz, frame.xy, frame.xz, frame.yz);
+                benchKernel<double>(options, frame, "min_distance_brute", box);
+                benchKernel<float>(options, frame, "min_distance_brute_f32", box);
+                // Mismos puntos sin caja y con una caja inclinada
+                benchKernel<double>(options, frame, "min_distance_brute_nobox", PeriodicBox(0, 0, 0));
+                benchKernel<double>(options, frame, "min_distance_brute_triclinic",
+                                    PeriodicBox(box.Lx, box.Ly, box.Lz, 0.1 * box.Lx, 0.1 * box.Lx, 0.1 * box.Ly));
+            }
+            if (selected(options, "cells")) {
+                benchCells<double>(options, frame, "min_distance_cells");
+                benchCells<float>(options, frame, "min_distance_cells_f32");
+            }
+        }
+        if (selected(options, "histogram")) {
+            benchHistogram(options);
+        }
+        if (selected(options, "e2e")) {
+            benchEndToEnd(options);
+        }
+        if (selected(options, "precision")) {
+            benchPrecision(options);
+        }
+        if (selected(options, "comments")) {
+            benchComments(options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// bench/syntheticTrajectory.cpp
+#include "SyntheticTrajectory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr double proteinDensity = 0.1;   // Átomos por Å³
+constexpr double waterDensity = 0.0334;  // Moléculas por Å³
+
+double wrap(double x, double L) {
+    x = std::fmod(x, L);
+    return x < 0 ? x + L : x;
+}
+
+// Escritura con un buffer grande: los frames pesan decenas de MB
+class Output {
+private:
+    std::FILE* file;
+    std::vector<char> buffer;
+
+public:
+    explicit Output(const std::string& filename) : buffer(1 << 20) {
+        file = std::fopen(filename.c_str(), "w");
+        if (!file) {
+            throw std::runtime_error("No se pudo crear el archivo: " + filename);
+        }
+        std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+    }
+    ~Output() { std::fclose(file); }
+
+    std::FILE* get() { return file; }
+};
+
+} // namespace
+
+double SyntheticTrajectory::boxSize() const {
+    return std::cbrt(waters / waterDensity + proteinAtoms / proteinDensity);
+}
+
+void SyntheticTrajectory::write(const std::string& directory) const {
+    std::filesystem::create_directories(directory);
+
+    const double L = boxSize();
+    const double radius = std::cbrt(3.0 * proteinAtoms / (4.0 * M_PI * proteinDensity));
+    const double center = 0.5 * L;
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    // Proteína: puntos uniformes dentro de una esfera
+    static const char* proteinElements[] = {"C", "C", "C", "N", "O", "S", "H", "H", "H", "H"};
+    std::vector<double> px(proteinAtoms), py(proteinAtoms), pz(proteinAtoms);
+    std::vector<const char*> elements(proteinAtoms);
+    for (size_t i = 0; i < proteinAtoms; ++i) {
+        double x, y, z;
+        do {
+            x = 2 * uniform(rng) - 1;
+            y = 2 * uniform(rng) - 1;
+            z = 2 * uniform(rng) - 1;
+        } while (x*x + y*y + z*z > 1);
+        px[i] = center + radius * x;
+        py[i] = center + radius * y;
+        pz[i] = center + radius * z;
+        elements[i] = proteinElements[static_cast<size_t>(uniform(rng) * 10) % 10];
+    }
+
+    // Aguas: uniformes en la caja, fuera del glóbulo
+    std::vector<double> wx(waters), wy(waters), wz(waters);
+    for (size_t i = 0; i < waters; ++i) {
+        double dx, dy, dz;
+        do {
+            wx[i] = L * uniform(rng);
+            wy[i] = L * uniform(rng);
+            wz[i] = L * uniform(rng);
+            dx = wx[i] - center;
+            dy = wy[i] - center;
+            dz = wz[i] - center;
+        } while (dx*dx + dy*dy + dz*dz < radius * radius);
+    }
+
+    for (size_t f = 0; f < frames; ++f) {
+        const std::string base = directory + "/frame_" + std::to_string(f);
+        {
+            Output out(base + ".xyz");
+            std::fprintf(out.get(), "%zu\nLx=%.4f Ly=%.4f Lz=%.4f\n", proteinAtoms, L, L, L);
+            for (size_t i = 0; i < proteinAtoms; ++i) {
+                std::fprintf(out.get(), "%s %.4f %.4f %.4f\n", elements[i], px[i], py[i], pz[i]);
+            }
+        }
+        {
+            // Q4/Q6 entre 0 y 1 y W4/W6 chicos, con valores típicos del agua líquida
+            Output out(base + "_bop.xyz");
+            std::fprintf(out.get(), "%zu\nframe=%zu\n", waters, f);
+            for (size_t i = 0; i < waters; ++i) {
+                const double q4 = std::clamp(0.1 + 0.05 * normal(rng), 0.0, 1.0);
+                const double q6 = std::clamp(0.35 + 0.1 * normal(rng), 0.0, 1.0);
+                std::fprintf(out.get(), "O %.4f %.4f %.4f %.6f %.6f %.6f %.6f\n",
+                             wrap(wx[i], L), wrap(wy[i], L), wrap(wz[i], L),
+                             q4, q6, 0.02 * normal(rng), 0.01 * normal(rng));
+            }
+        }
+
+        for (size_t i = 0; i < proteinAtoms; ++i) {
+            px[i] += proteinStep * normal(rng);
+            py[i] += proteinStep * normal(rng);
+            pz[i] += proteinStep * normal(rng);
+        }
+        for (size_t i = 0; i < waters; ++i) {
+            wx[i] += waterStep * normal(rng);
+            wy[i] += waterStep * normal(rng);
+            wz[i] += waterStep * normal(rng);
+        }
+    }
+}
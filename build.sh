@@ -49,13 +49,61 @@ Descripción:
 
 Uso del programa después de compilar:
     ./bop-rdf <directorio> [opciones]
+    ./bop-rdf <proteina.xyz> <bop.xyz> [opciones]
+    ./bop-rdf convert <directorio> [-o <caché>] [-f32] [-t <número>]
 Opciones:
   -p <número>    Parámetro de orden a usar (1-4:Q4,Q6,W4,W6, por defecto: 2-Q6)
+                 Acepta una lista (-p 1,3) o all; las distancias se calculan una vez
+                 y se escribe un archivo por parámetro (histograma-Q4.dat, ...)
+  -combined      Con varios parámetros, escribir un solo archivo con todas las columnas
+  -2d <número>   Histograma conjunto distancia × parámetro con ese número de bins del
+                 parámetro, en la misma pasada (histograma-2d-Q6.dat, ...)
+  -prange <min>,<max> Rango del parámetro en -2d (por defecto: [0,1] para Q, [-0.2,0.2] para W)
+  -block <número> Promedios por bloques de ese número de frames consecutivos, con el
+                 error estándar entre bloques (histograma-blocks-Q6.dat, ...)
+  -series        Serie temporal de los promedios por bin de cada frame (histograma-series-Q6.dat, ...)
   -t <número>    Número de hilos (por defecto: CPUs disponibles)
+  -affinity <modo> Fijar los hilos a CPUs: compact (llenar un nodo NUMA antes del
+                 siguiente), scatter (repartirlos entre nodos) o una lista 0-15,32-47
+                 (por defecto: none, sin fijar)
   -o <archivo>   Archivo de salida (por defecto: histograma.dat)
   -min <valor>   Distancia mínima (por defecto: 0.0)
   -max <valor>   Distancia máxima (por defecto: 20.0)
   -bins <número> Número de bins (por defecto: 100)
+  -binning <esquema> Otro juego de bins, llenado con las mismas distancias: min:max:bins,
+                 log:min:max:bins o un archivo con los bordes; repetible
+                 (histograma-binning1.dat, ...)
+  -search <modo> Búsqueda de distancias: cells (grilla de celdas) o brute
+                 (fuerza bruta, referencia) (por defecto: cells)
+  -kernel <nombre> Núcleo de distancias: auto, scalar, avx2, avx512 (por defecto: auto)
+  -precision <p> Precisión de la búsqueda de distancias: double o float (la mitad de
+                 memoria, error ~1e-5 Å; los histogramas siguen en double) (por defecto: double)
+  -skin <valor>  Piel de la lista de Verlet en Å: reutiliza los vecinos entre frames
+                 consecutivos, procesados en orden (por defecto: 0, desactivada)
+  -stream        Leer las aguas de cada archivo XYZ por tandas, buscando y acumulando
+                 cada tanda sin armar el frame: la memoria no crece con las aguas
+  -protein <sel> Átomos de proteína a cargar: all, heavy (sin H) o lista C,N,O
+                 (por defecto: all)
+  -water <sel>   Moléculas de agua a cargar, con la misma sintaxis (por defecto: O)
+  -cache <archivo> Caché binario a usar si está al día (por defecto: <directorio>/frames.bopcache)
+  -nocache       Ignorar el caché binario y leer siempre los archivos XYZ
+  -manifest <archivo> Índice de los pares de archivos, válido mientras el directorio no
+                 cambie (por defecto: <directorio>/frames.bopindex)
+  -nomanifest    Recorrer siempre el directorio, sin leer ni escribir el índice
+  -readers <número> Hilos lectores de archivos (por defecto: 2)
+  -inflight <número> Frames leídos en memoria a la vez (por defecto: 2*hilos+lectores)
+  -checkpoint <archivo> Guardar el estado periódicamente en ese archivo
+  -every <número> Frames procesados entre checkpoints (por defecto: 1000)
+  -resume        Continuar desde el checkpoint (por defecto: <salida>.ckpt),
+                 procesando sólo los frames que faltan o que aparecieron después
+  -progress <s>  Segundos entre reportes de avance, con frames/s y tiempo restante
+                 (por defecto: 5; 0 lo desactiva)
+  -metrics <archivo> Escribir en JSON el tiempo por etapa, CPU, memoria máxima y bytes leídos
+  -begin <n>, -end <n> Procesar sólo los frames con número en [begin, end)
+  -stride <n>    Procesar uno de cada n frames del rango (por defecto: 1)
+  -shard <i>/<N> Procesar la porción i (0 a N-1) de N partes contiguas de los frames
+                 y escribir un resultado parcial (por defecto: <salida>.<i>-<N>.part)
+  -partial <archivo> Escribir los acumuladores en bruto para bop-merge en lugar del histograma
 
 Ejemplo:
   ./bop-rdf /ruta/a/mis/datos -p 2 -t 8 -o resultado.csv
@@ -0,0 +1,91 @@
+// include/Binning.h
+#ifndef BINNING_H
+#define BINNING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bordes de los bins de distancia: uniformes (mínimo, máximo, cantidad) o
+// arbitrarios (por ejemplo, espaciados en log o leídos de un archivo). Cada
+// bin es [borde_i, borde_i+1), salvo el último, que incluye el máximo.
+//
+// Con bordes arbitrarios el bin se busca sin búsqueda binaria: una tabla
+// precalculada sobre una grilla uniforme, con celdas no más anchas que el
+// bin más angosto, da el bin del comienzo de cada celda. Como una celda
+// contiene a lo sumo un borde, basta una comparación para corregirlo.
+class Binning {
+private:
+    std::vector<double> edges;     // numBins + 1 bordes crecientes
+    bool uniform;
+    double width;                  // Ancho de los bins uniformes
+    double invCell;                // Inversa del ancho de celda de la tabla
+    std::vector<int32_t> table;    // Bin del comienzo de cada celda
+
+    static constexpr size_t maxTableCells = size_t(1) << 20;
+
+    int tableBin(double distance) const {
+        const size_t cell = std::min(static_cast<size_t>((distance - edges.front()) * invCell),
+                                     table.size() - 1);
+        int bin = table[cell];
+        const int last = static_cast<int>(edges.size()) - 2;
+        while (bin < last && distance >= edges[bin + 1]) {
+            ++bin;
+        }
+        while (bin > 0 && distance < edges[bin]) {
+            --bin;
+        }
+        return bin;
+    }
+
+public:
+    // numBins bins uniformes en [minDistance, maxDistance]
+    Binning(double minDistance, double maxDistance, int numBins);
+
+    // Bordes arbitrarios, estrictamente crecientes (al menos dos)
+    explicit Binning(std::vector<double> edges);
+
+    // "min:max:bins" (uniforme), "log:min:max:bins" (bordes espaciados en
+    // log, min > 0) o el nombre de un archivo con un borde por línea (o
+    // separados por espacios; "#" comienza un comentario)
+    static Binning parse(const std::string& spec);
+
+    int numBins() const { return static_cast<int>(edges.size()) - 1; }
+    bool isUniform() const { return uniform; }
+    double lower() const { return edges.front(); }
+    double upper() const { return edges.back(); }
+    double lowerEdge(int bin) const { return edges[bin]; }
+    double upperEdge(int bin) const { return edges[bin + 1]; }
+    const std::vector<double>& getEdges() const { return edges; }
+
+    // Centro del bin (en los uniformes, el mismo cálculo de siempre)
+    double center(int bin) const {
+        return uniform ? edges.front() + (bin + 0.5) * width : 0.5 * (edges[bin] + edges[bin + 1]);
+    }
+
+    // Bin de distance, o -1 si está fuera de [lower(), upper()]
+    int binOf(double distance) const {
+        if (!(distance >= edges.front() && distance <= edges.back())) {
+            return -1;
+        }
+        if (uniform) {
+            const int bin = static_cast<int>((distance - edges.front()) / width);
+            return std::min(std::max(bin, 0), numBins() - 1);
+        }
+        return tableBin(distance);
+    }
+
+    bool operator==(const Binning& other) const { return edges == other.edges; }
+
+    // Descripción corta: "0-6 Å, 120 bins" o "bordes de 0.1 a 20 Å, 40 bins"
+    std::string describe() const;
+
+    // Bordes en binario (cantidad y valores); load falla si están mal formados
+    void save(std::ostream& out) const;
+    static Binning load(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,72 @@
+// include/BlockAverages.h
+#ifndef BLOCKAVERAGES_H
+#define BLOCKAVERAGES_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// Promedios por bin de distancia agrupados por frame, en la misma pasada
+// que los histogramas. Cada frame se suma al bloque de blockSize frames
+// consecutivos que le corresponde según su posición en la trayectoria; la
+// dispersión de los promedios de los bloques da un error estándar que
+// tiene en cuenta la correlación temporal. Opcionalmente guarda también la
+// serie temporal de los promedios de cada frame.
+class BlockAverages {
+public:
+    // Sumas y conteos de un frame, numParameters × bins (por parámetro)
+    struct FrameBins {
+        std::vector<double> sum;
+        std::vector<long long> count;
+    };
+
+private:
+    double minDistance, maxDistance;
+    int numBins;
+    double binWidth;
+    size_t numParameters;
+    size_t blockSize;                        // 0: sin bloques
+    bool keepSeries;
+
+    std::mutex mutex;
+    std::map<size_t, FrameBins> blocks;      // Por índice de bloque
+    std::map<size_t, std::pair<int, std::vector<float>>> series;  // Por posición: frame y promedios
+
+public:
+    BlockAverages(double minDist, double maxDist, int bins, size_t numParameters,
+                  size_t blockSize, bool keepSeries);
+
+    size_t getBlockSize() const { return blockSize; }
+    bool hasSeries() const { return keepSeries; }
+
+    FrameBins emptyFrame() const;
+
+    // Agrega las muestras de un bloque de aguas del parámetro p a frame
+    // (sin sincronización: frame pertenece a un solo hilo)
+    void accumulate(FrameBins& frame, size_t parameter, std::span<const double> distances,
+                    std::span<const double> parameters) const;
+
+    // Suma un frame terminado a su bloque y a la serie. Segura entre hilos.
+    void addFrame(size_t sequence, int frameNumber, const FrameBins& frame);
+
+    // Por parámetro: r, promedio de los promedios de los bloques, su error
+    // estándar (std / sqrt(nb)) y nb, la cantidad de bloques con muestras
+    // en el bin
+    void saveBlocks(const std::string& filename, size_t parameter, const std::string& name) const;
+
+    // Por parámetro: una fila por frame, en orden, con el número de frame
+    // y el promedio de cada bin (nan si el bin no tiene muestras)
+    void saveSeries(const std::string& filename, size_t parameter, const std::string& name) const;
+
+    // Sumas de los bloques para el checkpoint (la serie no se guarda).
+    // load() suma los bloques leídos a los que ya hay: un bloque partido
+    // entre dos resultados parciales queda completo.
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
+};
+
+#endif
@@ -0,0 +1,67 @@
+// include/BoundedQueue.h
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// Cola circular de capacidad fija para productores/consumidores. push
+// bloquea mientras la cola está llena (contrapresión) y pop mientras está
+// vacía. Después de close(), pop devuelve false cuando ya no quedan
+// elementos.
+template<class T>
+class BoundedQueue {
+private:
+    std::vector<T> ring;
+    size_t head;
+    size_t count;
+    bool closed;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+public:
+    explicit BoundedQueue(size_t capacity)
+        : ring(capacity), head(0), count(0), closed(false) {}
+
+    // Devuelve false si la cola fue cerrada
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return closed || count < ring.size(); });
+        if (closed) {
+            return false;
+        }
+        ring[(head + count) % ring.size()] = std::move(value);
+        count++;
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || count > 0; });
+        if (count == 0) {
+            return false;
+        }
+        value = std::move(ring[head]);
+        head = (head + 1) % ring.size();
+        count--;
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+};
+
+#endif
@@ -0,0 +1,61 @@
+// include/CellList.h
+#ifndef CELLLIST_H
+#define CELLLIST_H
+
+#include "Types.h"
+#include "DistanceKernel.h"
+#include <vector>
+
+// Grilla de celdas (linked-cell) con los átomos de la proteína de un frame.
+// Los átomos se ordenan por celda, de modo que cada fila de celdas a lo largo
+// de x es un rango contiguo que se pasa entero al núcleo de distancias.
+// La búsqueda del átomo más cercano recorre capas de celdas alrededor del
+// punto, de adentro hacia afuera, hasta que el mínimo queda confirmado.
+// En una caja triclínica las celdas se arman sobre las coordenadas
+// fraccionarias y las cotas usan la distancia entre planos. La caja debe
+// ser periódica (no BoxKind::None).
+// Las coordenadas ordenadas y el núcleo usan precisión Real (instanciado
+// para double y float); las distancias se devuelven siempre en double.
+template <typename Real>
+class CellList {
+private:
+    PeriodicBox box;
+    int nx, ny, nz;
+    double cellX, cellY, cellZ;    // Largo de la celda a lo largo de cada eje
+    double spacingX, spacingY, spacingZ;  // Distancia entre planos de celdas
+    double minCellWidth;
+    double tolerance;              // Margen para errores de redondeo en la cota
+    MinDistance2Kernel<Real> kernel;
+
+    std::vector<int> cellStart;    // Primer átomo de cada celda (tamaño nCeldas+1)
+    std::vector<Real> atomX, atomY, atomZ;
+    std::vector<int> atomIndex;    // Índice original de cada átomo ordenado
+
+    int cellIndex(double coord, double cellWidth, int n) const;
+    int cellOf(double x, double y, double z) const;
+
+    // Recorre las celdas [cx+dxFrom, cx+dxTo] de la fila (cy, cz)
+    void scanRow(int cx, int dxFrom, int dxTo, int cy, int cz,
+                 const Real* wx, const Real* wy, const Real* wz, size_t n,
+                 Real* minDist2) const;
+
+    // Búsqueda por capas para un grupo de aguas de la misma celda
+    void searchGroup(int cell, const Real* wx, const Real* wy, const Real* wz,
+                     size_t n, double maxDistance, Real* minDist2) const;
+
+public:
+    CellList(const PositionsView& atoms, const PeriodicBox& box, double cellSize);
+
+    // Calcula la distancia mínima (imagen mínima) de cada agua a la proteína.
+    // Las aguas sin átomos a menos de maxDistance reciben un valor mayor que
+    // maxDistance sin completar la búsqueda.
+    void findMinDistances(const double* wx, const double* wy, const double* wz,
+                          size_t numWaters, double maxDistance, double* minDist) const;
+
+    // Agrega a neighbors los índices originales de los átomos a menos de
+    // radius (imagen mínima) del punto (x, y, z)
+    void findNeighbors(double x, double y, double z, double radius,
+                       std::vector<int>& neighbors) const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+// include/CompressedInput.h
+#ifndef COMPRESSEDINPUT_H
+#define COMPRESSEDINPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compresión de un archivo de entrada según su extensión
+enum class Compression {
+    None,
+    Gzip,   // .gz (zlib)
+    Zstd    // .zst (libzstd)
+};
+
+Compression compressionOf(std::string_view filename);
+
+// filename sin la extensión de compresión (frame_1.xyz.gz -> frame_1.xyz)
+std::string_view withoutCompression(std::string_view filename);
+
+// Flujo secuencial de bytes. read() devuelve 0 sólo al final.
+class InputStream {
+public:
+    virtual ~InputStream() = default;
+    virtual size_t read(char* buffer, size_t size) = 0;
+};
+
+// Abre filename, descomprimiendo según la extensión. Con readAhead la
+// descompresión corre en un hilo propio que va llenando bloques por
+// adelantado, así se superpone con el parseo y el cálculo (trayectorias
+// grandes); sin compresión se lee directo del archivo.
+std::unique_ptr<InputStream> openInput(const std::string& filename, bool readAhead = false);
+
+// Descomprime filename entero en out (reutilizando su capacidad).
+// Devuelve los bytes comprimidos leídos del disco.
+uint64_t decompressFile(const std::string& filename, std::vector<char>& out);
+
+#endif
@@ -0,0 +1,94 @@
+// include/DistanceKernel.h
+#ifndef DISTANCEKERNEL_H
+#define DISTANCEKERNEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+// Tipo de caja de un frame, según su línea de comentario
+enum class BoxKind {
+    None,           // Sin caja (o incompleta): distancias directas, sin imagen mínima
+    Orthorhombic,   // Lx, Ly, Lz
+    Triclinic       // Además factores de inclinación xy, xz, yz
+};
+
+// Caja periódica con las inversas precalculadas, para aplicar la imagen
+// mínima multiplicando en lugar de dividir. La triclínica sigue la
+// convención de LAMMPS: vectores a = (Lx, 0, 0), b = (xy, Ly, 0) y
+// c = (xz, yz, Lz). Sin las tres longitudes positivas no es periódica.
+struct PeriodicBox {
+    double Lx, Ly, Lz;
+    double invLx, invLy, invLz;
+    double xy, xz, yz;
+    BoxKind kind;
+
+    PeriodicBox(double Lx_, double Ly_, double Lz_,
+                double xy_ = 0.0, double xz_ = 0.0, double yz_ = 0.0)
+        : Lx(Lx_), Ly(Ly_), Lz(Lz_),
+          invLx(0.0), invLy(0.0), invLz(0.0),
+          xy(xy_), xz(xz_), yz(yz_), kind(BoxKind::None) {
+        if (Lx > 0 && Ly > 0 && Lz > 0) {
+            invLx = 1.0 / Lx;
+            invLy = 1.0 / Ly;
+            invLz = 1.0 / Lz;
+            kind = xy != 0 || xz != 0 || yz != 0 ? BoxKind::Triclinic : BoxKind::Orthorhombic;
+        }
+    }
+
+    bool operator==(const PeriodicBox& other) const {
+        return Lx == other.Lx && Ly == other.Ly && Lz == other.Lz &&
+               xy == other.xy && xz == other.xz && yz == other.yz;
+    }
+
+    // Imagen mínima de un desplazamiento. En la triclínica se reduce en
+    // coordenadas fraccionarias eje por eje (c, b, a): el resultado queda
+    // en [-L/2, L/2] en cada eje y es la imagen más cercana siempre que
+    // ésta esté a menos de min(Lx, Ly, Lz)/2.
+    void minimumImage(double& dx, double& dy, double& dz) const {
+        if (kind == BoxKind::Triclinic) {
+            const double nz = std::nearbyint(dz * invLz);
+            dx -= xz * nz;
+            dy -= yz * nz;
+            dz -= Lz * nz;
+            const double ny = std::nearbyint(dy * invLy);
+            dx -= xy * ny;
+            dy -= Ly * ny;
+            dx -= Lx * std::nearbyint(dx * invLx);
+        } else if (kind == BoxKind::Orthorhombic) {
+            dx -= Lx * std::nearbyint(dx * invLx);
+            dy -= Ly * std::nearbyint(dy * invLy);
+            dz -= Lz * std::nearbyint(dz * invLz);
+        }
+    }
+};
+
+// Núcleo de distancias: para cada agua w (w < numWaters) actualiza minDist2[w]
+// con la menor distancia al cuadrado (imagen mínima) a los átomos [0, numAtoms).
+// Las coordenadas se reciben en formato SoA, en la precisión Real (double o
+// float) con la que se calcula. Para una misma precisión todas las variantes
+// usan la misma aritmética (sin FMA, redondeo al par más cercano), por lo que
+// dan resultados idénticos entre sí.
+template <typename Real>
+using MinDistance2Kernel = void (*)(const Real* ax, const Real* ay, const Real* az,
+                                    size_t numAtoms,
+                                    const Real* wx, const Real* wy, const Real* wz,
+                                    size_t numWaters,
+                                    const PeriodicBox& box, Real* minDist2);
+
+// Cantidad de aguas que el núcleo procesa juntas contra cada bloque de átomos
+constexpr size_t kernelWaterBlock = 4;
+
+// Núcleo seleccionado según las instrucciones disponibles en la CPU, en
+// precisión Real (instanciado para double y float) y especializado para el
+// tipo de caja: sin caja no se envuelve nada y la ortorrómbica no paga los
+// términos de inclinación
+template <typename Real = double>
+MinDistance2Kernel<Real> distanceKernel(BoxKind kind);
+const char* distanceKernelName();
+
+// Fuerza una variante ("auto", "scalar", "avx2", "avx512"). Lanza
+// std::runtime_error si el nombre es desconocido o la CPU no la soporta.
+void selectDistanceKernel(const std::string& name);
+
+#endif
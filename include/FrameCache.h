@@ -0,0 +1,115 @@
+// include/FrameCache.h
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include "MappedFile.h"
+#include "Types.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Caché binario de una trayectoria. Se construye una vez a partir del
+// directorio de archivos XYZ (subcomando convert) y en las corridas
+// siguientes se lee mapeado en memoria, sin volver a parsear texto.
+//
+// Formato (orden de bytes nativo):
+//   cabecera (64 bytes)
+//   bloques de frames, cada arreglo alineado a 8 bytes:
+//     proteína x, y, z (float o double), elementos (uint8)
+//     aguas x, y, z (float o double), elementos (uint8)
+//     aguas Q4, Q6, W4, W6 (double)
+//   tabla de elementos (numElements × 8 bytes, nombres terminados en '\0')
+//   índice de frames (numFrames × FrameCacheEntry)
+struct FrameCacheHeader {
+    char magic[8];             // "BOPCACHE"
+    uint32_t version;
+    uint32_t realSize;         // 4 (float) o 8 (double) para las coordenadas
+    uint64_t numFrames;
+    uint64_t indexOffset;
+    uint64_t elementsOffset;
+    uint64_t numElements;
+    uint8_t reserved[16];
+};
+
+// La versión 1 no tiene los factores de inclinación: sus entradas son el
+// prefijo de éstas (56 bytes) y se leen como cajas sin inclinación
+struct FrameCacheEntry {
+    int64_t frameNumber;
+    uint64_t offset;
+    uint64_t numAtoms;
+    uint64_t numWaters;
+    double Lx, Ly, Lz;
+    double xy, xz, yz;         // Desde la versión 2
+};
+
+class FrameCache {
+private:
+    std::string filename;
+    MappedFile file;
+    const FrameCacheHeader* header;
+    const char* index;
+    size_t entrySize;                   // Bytes por entrada del índice (según la versión)
+    std::vector<ElementId> elements;    // Identificador de cada elemento del caché
+
+    const FrameCacheEntry& entry(size_t i) const {
+        return *reinterpret_cast<const FrameCacheEntry*>(index + i * entrySize);
+    }
+
+public:
+    static constexpr uint32_t version = 2;
+
+    // Ruta por defecto del caché dentro del directorio de la trayectoria
+    static std::string defaultPath(const std::string& directory);
+
+    // true si el caché existe y no es más viejo que el directorio ni que
+    // ninguno de los archivos fuente. listedTime es la fecha del directorio
+    // cuando se listaron sources (índice de frames): si sigue siendo la
+    // actual, el directorio puede ser más nuevo que el caché sólo por el
+    // índice, y alcanza con las fechas de los archivos fuente.
+    static bool isUpToDate(const std::string& cacheFile, const std::string& directory,
+                           const std::vector<std::string>& sources,
+                           std::optional<std::filesystem::file_time_type> listedTime = std::nullopt);
+
+    explicit FrameCache(const std::string& filename);
+
+    size_t size() const { return header->numFrames; }
+    int frameNumber(size_t i) const { return static_cast<int>(entry(i).frameNumber); }
+
+    // Copia el frame i en frame, reutilizando la capacidad de sus arreglos.
+    // Sólo se copian los átomos de proteína de keepProtein y las moléculas
+    // de keepWater. Devuelve los bytes del caché que ocupa el frame. Falla
+    // si el bloque del frame sale del archivo o nombra un elemento que no
+    // está en la tabla (caché inválido).
+    size_t readFrame(size_t i, FrameData& frame,
+                   const ElementMask& keepProtein = ElementMask::all(),
+                   const ElementMask& keepWater = ElementMask::all()) const;
+};
+
+// Escritura incremental del caché: los frames se agregan en orden y
+// finish() completa la tabla de elementos, el índice y la cabecera.
+// Se escribe a un archivo temporal que se renombra al terminar.
+class FrameCacheWriter {
+private:
+    std::string filename;
+    std::string tempFilename;
+    std::ofstream out;
+    bool singlePrecision;
+    std::vector<FrameCacheEntry> index;
+    std::vector<ElementId> elements;    // Elementos del caché, en orden
+    std::vector<int> cacheIds;          // Por ElementId: índice en el caché o -1
+
+    uint8_t elementId(ElementId element);
+    void writeCoordinates(const std::vector<double>& values);
+    void pad();
+
+public:
+    FrameCacheWriter(const std::string& filename, bool singlePrecision);
+
+    void addFrame(const FrameData& frame);
+    void finish();
+};
+
+#endif
@@ -0,0 +1,56 @@
+// include/FrameManifest.h
+#ifndef FRAMEMANIFEST_H
+#define FRAMEMANIFEST_H
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Pares (proteína, aguas) de un directorio de frames, ordenados por número
+// de frame
+using FilePairs = std::vector<std::pair<int, std::pair<std::string, std::string>>>;
+
+// Índice de los pares de un directorio guardado junto a él, para que las
+// corridas siguientes no tengan que recorrerlo. Guarda la fecha del
+// directorio tomada antes de recorrerlo y es válido mientras siga siendo
+// la misma: agregar, borrar o renombrar archivos, incluso durante el
+// recorrido, la cambia y lo invalida. El índice se reserva (se crea vacío)
+// antes de tomar la fecha y después se escribe en el lugar, así que
+// escribirlo no cambia el directorio.
+//
+// Formato (texto): "# bop-rdf frames v2", la fecha del directorio (en
+// ticks del reloj de archivos), la cantidad de pares, una línea por par
+// con el número de frame y los nombres de los dos archivos (relativos al
+// directorio), separados por tabuladores, y "# fin".
+class FrameManifest {
+public:
+    // Ruta por defecto del índice dentro del directorio
+    static std::string defaultPath(const std::string& directory);
+
+    // Una sola pasada por el directorio (readdir): clasifica cada entrada
+    // por su nombre (frame_N.xyz, frame_N_bop.xyz, con .gz o .zst
+    // opcionales) y sólo consulta el tipo con stat si readdir no lo da.
+    // Si un frame está también comprimido se usa el archivo sin comprimir.
+    static FilePairs scan(const std::string& directory);
+
+    // Crea el índice vacío si no existe y devuelve la fecha del
+    // directorio, que hay que tomar antes de scan. Si no se puede crear
+    // (directorio de sólo lectura), save fallará después.
+    static std::filesystem::file_time_type reserve(const std::string& manifestFile,
+                                                   const std::string& directory);
+
+    // Pares del índice, o nada si no existe, no es válido o la fecha del
+    // directorio no es la que se tomó antes de recorrerlo. Con
+    // directoryTime, devuelve allí esa fecha.
+    static std::optional<FilePairs> load(const std::string& manifestFile,
+                                         const std::string& directory,
+                                         std::filesystem::file_time_type* directoryTime = nullptr);
+
+    // Escribe el índice en el lugar con la fecha que devolvió reserve
+    static void save(const std::string& manifestFile, const FilePairs& pairs,
+                     std::filesystem::file_time_type directoryTime);
+};
+
+#endif
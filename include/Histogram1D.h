@@ -2,26 +2,86 @@
 #ifndef HISTOGRAM1D_H
 #define HISTOGRAM1D_H
 
+#include "Binning.h"
 #include <vector>
 #include <string>
-#include <mutex>
+#include <span>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 
 class Histogram1D {
 private:
-    std::vector<double> sumValues;        // Suma de parámetros en cada bin
-    std::vector<double> sumSquaredValues; // Suma de cuadrados para la std
-    std::vector<int> counts;              // Conteo de muestras en cada bin
-    double minDistance, maxDistance;
+    // Acumulador de un bin: media y suma de cuadrados de las desviaciones
+    // (Welford). Es estable con millones de muestras y dos bins se combinan
+    // sin perder precisión, así que los shards, los checkpoints y los
+    // resultados parciales se suman exactamente igual.
+    struct Bin {
+        long long count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        void add(double value) {
+            ++count;
+            const double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+        }
+        void merge(const Bin& other);
+    };
+
+    // Acumulador local de un hilo. Cada shard reserva una línea de caché
+    // extra al final de sus bins para que dos shards nunca compartan línea.
+    // Los bins se reservan la primera vez que el hilo acumula en el shard,
+    // así quedan en la memoria de su nodo NUMA.
+    struct alignas(64) Shard {
+        std::vector<Bin> bins;
+    };
+
+    static constexpr size_t cacheLine = 64;
+    static constexpr size_t paddingBins = cacheLine / sizeof(Bin) + 1;
+
+    std::vector<Bin> totals;              // Bins combinados de todos los shards
+    std::vector<long long> counts;        // Conteo de muestras en cada bin
+    Binning binning;
     int numBins;
-    double binWidth;
-    std::mutex mutex;
+    std::vector<Shard> shards;
+
+    Bin* shardBins(size_t shard);
 
 public:
-    Histogram1D(double minDist, double maxDist, int bins);
-    void addDataPoint(double distance, double parameter);
+    // numShards: cantidad de acumuladores independientes (uno por hilo)
+    Histogram1D(double minDist, double maxDist, int bins, size_t numShards = 1);
+    // Bins arbitrarios (ver Binning)
+    explicit Histogram1D(const Binning& binning, size_t numShards = 1);
+
+    // Agregan muestras al shard indicado sin bloqueo. Cada shard debe ser
+    // usado por un solo hilo a la vez.
+    void addDataPoint(double distance, double parameter, size_t shard = 0);
+    void addDataPoints(std::span<const double> distances,
+                       std::span<const double> parameters, size_t shard = 0);
+
+    // Suma los shards en los totales y los vacía. Debe llamarse sin hilos
+    // acumulando, antes de saveToFile/printStatistics. Con only, sólo esos
+    // shards (los demás ya fueron plegados con foldShards).
+    void mergeShards(std::span<const size_t> only = {});
+
+    // Combina los shards de group en el primero y vacía los demás. Para
+    // los shards de un mismo nodo NUMA, desde un hilo de ese nodo.
+    void foldShards(std::span<const size_t> group);
+
+    int getNumBins() const { return numBins; }
+    double getBinCenter(int bin) const { return binning.center(bin); }
+    const Binning& getBinning() const { return binning; }
+    const std::vector<long long>& getCounts() const { return counts; }
+
+    // Estado combinado y configuración de los bins, en binario (con bins
+    // arbitrarios, también sus bordes). load() combina el estado leído con
+    // los totales (en un histograma vacío, lo copia) y falla si los bins
+    // no coinciden.
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
+
     std::pair<std::vector<double>, std::vector<double>> getAverageValues() const;
     void saveToFile(const std::string& filename) const;
     void printStatistics() const;
@@ -0,0 +1,73 @@
+// include/Histogram2D.h
+#ifndef HISTOGRAM2D_H
+#define HISTOGRAM2D_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Histograma conjunto distancia × valor del parámetro de orden: cuenta
+// cuántas aguas caen en cada par de bins, de modo que cada fila es la
+// distribución completa P(BOP | r). Como Histogram1D, acumula en shards
+// por hilo sin bloqueo; los conteos de los shards son enteros de 32 bits
+// para que cada fila ocupe pocas líneas de caché. Antes de que un shard
+// pueda desbordar, el mismo hilo lo vuelca en un arreglo de 64 bits propio
+// del shard.
+class Histogram2D {
+private:
+    // Como en Histogram1D, los conteos de un shard los reserva el hilo
+    // que acumula en él
+    struct alignas(64) Shard {
+        std::vector<uint32_t> counts;  // distBins × paramBins, por filas
+        std::vector<uint64_t> spilled; // Conteos volcados (sólo si hizo falta)
+        uint64_t samples = 0;          // Muestras en counts desde el último volcado
+    };
+
+    static constexpr size_t paddingCounts = 64 / sizeof(uint32_t);
+
+    double minDistance, maxDistance;
+    int distBins;
+    double distWidth;
+    double minParameter, maxParameter;
+    int paramBins;
+    double paramWidth;
+    std::vector<uint64_t> counts;      // Totales después de mergeShards
+    std::vector<Shard> shards;
+
+    uint32_t* shardCounts(size_t shard);
+    // Pasa los conteos del shard a spilled; ningún bin puede tener más
+    // muestras que las agregadas desde el volcado anterior
+    void spill(Shard& shard);
+
+public:
+    Histogram2D(double minDist, double maxDist, int distBins,
+                double minParam, double maxParam, int paramBins, size_t numShards = 1);
+
+    // Agrega muestras al shard indicado sin bloqueo. Las distancias fuera
+    // de rango se descartan igual que en Histogram1D; los parámetros fuera
+    // de rango se cuentan en el bin extremo, así cada fila suma lo mismo
+    // que el conteo del bin de distancia.
+    void addDataPoints(std::span<const double> distances,
+                       std::span<const double> parameters, size_t shard = 0);
+
+    // Suma los shards en los totales (de 64 bits) y los vacía
+    void mergeShards();
+
+    int getParameterBins() const { return paramBins; }
+    std::pair<double, double> getParameterRange() const { return {minParameter, maxParameter}; }
+
+    // Totales y configuración de los bins, en binario; load() suma los
+    // conteos leídos a los totales (ver Histogram1D)
+    void save(std::ostream& out) const;
+    void load(std::istream& in);
+
+    // Una fila por bin de distancia: el centro del bin y los conteos de
+    // cada bin del parámetro. La segunda línea de comentario lista los
+    // centros de los bins del parámetro; np.loadtxt lee la matriz directo.
+    void saveToFile(const std::string& filename, const std::string& parameterName) const;
+};
+
+#endif
@@ -0,0 +1,27 @@
+// include/MappedFile.h
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Archivo de solo lectura mapeado en memoria (RAII). El contenido se lee
+// directamente de la caché de páginas, sin copias intermedias.
+class MappedFile {
+private:
+    const char* data_;
+    size_t size_;
+
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+};
+
+#endif
@@ -0,0 +1,107 @@
+// include/Metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Etapas medidas del análisis
+enum class Stage {
+    Discovery,   // Búsqueda de los pares de archivos (findFilePairs)
+    Read,        // Lectura y parseo de los frames (XYZ, caché o trayectoria)
+    Search,      // Distancia mínima de cada agua a la proteína
+    Histogram,   // Acumulación en histogramas y bloques
+    Output,      // Checkpoints y archivos de salida
+    Count
+};
+
+const char* stageName(Stage stage);
+
+// Tiempos por etapa acumulados por hilo: cada hilo suma en su propia
+// ranura (sin compartir líneas de caché), así medir un bloque cuesta dos
+// lecturas del reloj y unas sumas sin contención. report() agrega las
+// ranuras al final.
+class Metrics {
+private:
+    static constexpr size_t numStages = static_cast<size_t>(Stage::Count);
+    static constexpr size_t numSlots = 64;   // Hilos por encima comparten ranura
+
+    struct alignas(64) Slot {
+        std::array<std::atomic<uint64_t>, numStages> wallNs{};
+        std::array<std::atomic<uint64_t>, numStages> cpuNs{};
+        std::array<std::atomic<uint64_t>, numStages> calls{};
+        std::atomic<uint64_t> bytesRead{0};
+    };
+
+    std::array<Slot, numSlots> slots;
+    std::chrono::steady_clock::time_point start;
+
+    static Slot& slotOf(std::array<Slot, numSlots>& slots);
+
+public:
+    // Tiempo de CPU del hilo actual (ns)
+    static uint64_t threadCpuNs();
+
+    Metrics();
+
+    // Mide el bloque en el que vive (tiempo de reloj y de CPU del hilo)
+    class Timer {
+    private:
+        Metrics& metrics;
+        Stage stage;
+        std::chrono::steady_clock::time_point wallStart;
+        uint64_t cpuStart;
+
+    public:
+        Timer(Metrics& m, Stage s)
+            : metrics(m), stage(s), wallStart(std::chrono::steady_clock::now()),
+              cpuStart(threadCpuNs()) {}
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+    };
+
+    void addBytesRead(uint64_t bytes);
+    uint64_t bytesRead();
+
+    // Segundos desde la construcción
+    double elapsed() const;
+
+    // Archivo JSON con el tiempo total, el de CPU del proceso, la memoria
+    // máxima, los bytes leídos y, por etapa, el tiempo de reloj y de CPU
+    // sumado sobre los hilos y la cantidad de mediciones
+    void report(const std::string& filename, size_t threads, size_t frames);
+};
+
+// Hilo que muestra el avance (frames, frames/s y tiempo restante estimado)
+// cada interval segundos mientras vive el objeto. total 0: desconocido.
+class ProgressReporter {
+private:
+    const std::atomic<int>& processed;
+    size_t total;
+    double interval;
+    std::chrono::steady_clock::time_point start;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable stopped;
+    std::thread thread;
+
+    void run();
+    void print(bool last);
+
+public:
+    ProgressReporter(const std::atomic<int>& processed, size_t total, double interval);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+};
+
+#endif
@@ -4,7 +4,20 @@
 
 #include "ThreadPool.h"
 #include "Histogram1D.h"
+#include "Histogram2D.h"
+#include "BlockAverages.h"
 #include "Types.h"
+#include "CellList.h"
+#include "MappedFile.h"
+#include "XyzParser.h"
+#include "FrameCache.h"
+#include "TrajectoryReader.h"
+#include "BoundedQueue.h"
+#include "VerletList.h"
+#include "Metrics.h"
+#include "CompressedInput.h"
+#include "FrameManifest.h"
+#include "Topology.h"
 #include <string>
 #include <atomic>
 #include <vector>
@@ -15,39 +28,331 @@
 #include <map>
 #include <filesystem>  // Para explorar el directorio
 #include <algorithm>   // Para ordenar
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <limits>
+
+// Frames que procesa una corrida: los números de frame en [begin, end),
+// uno de cada stride y, de esos, la porción shard de numShards partes
+// contiguas (de 0 a numShards-1)
+struct FrameRange {
+    int begin = std::numeric_limits<int>::min();
+    int end = std::numeric_limits<int>::max();
+    int stride = 1;
+    size_t shard = 0;
+    size_t numShards = 1;
+};
+
+// Estrategia para buscar el átomo de proteína más cercano a cada agua
+enum class SearchMode {
+    BruteForce,  // Recorre todos los átomos (modo de referencia)
+    CellList     // Grilla de celdas con búsqueda por capas
+};
+
+// Precisión de las coordenadas con las que se buscan las distancias. Los
+// frames se leen en double y los histogramas acumulan siempre en double.
+enum class Precision {
+    Double,      // Referencia
+    Float        // Grilla, átomos y núcleo en float (mitad de memoria, el doble de carriles SIMD)
+};
+
+// Histograma de un parámetro de orden ya combinado (finalize)
+struct HistogramResult {
+    int parameterIndex;              // 1-4: Q4, Q6, W4, W6
+    std::vector<double> distance;    // Centro de cada bin
+    std::vector<double> average;     // Promedio del parámetro en el bin
+    std::vector<double> stddev;      // Desviación estándar
+    std::vector<long long> count;    // Muestras en el bin
+};
 
 class ProteinWaterAnalyzer {
 private:
     ThreadPool pool;
-    Histogram1D histogram;
+    std::vector<int> parameterIndices;     // Parámetros de orden analizados (1-4)
+    std::vector<Histogram1D> histograms;   // Un histograma por parámetro
+    std::vector<Histogram2D> jointHistograms; // Distancia × parámetro (sólo con -2d)
+    std::unique_ptr<BlockAverages> blockAverages; // Sólo con -block o -series
     std::atomic<int> processedFrames;
     int totalFrames;
+    SearchMode searchMode;
+    Precision precision;
+    double minDistance, maxDistance;
+    int distanceBins;
+    std::vector<Binning> binnings;         // Esquemas de bins adicionales (-binning)
+    std::vector<Histogram1D> binnedHistograms; // Uno por esquema y parámetro, por esquema
+    double searchDistance;                 // Mayor distancia que algún histograma necesita
+    std::unique_ptr<FrameCache> cache;  // Caché mapeado mientras se procesa
+    size_t numReaders;                  // Hilos lectores del pipeline
+    size_t framesInFlight;              // Buffers de frame reutilizables
+    std::unique_ptr<VerletList> verlet; // Sólo con -skin
+    ElementMask proteinSelection;       // Átomos de proteína que se cargan
+    ElementMask waterSelection;         // Moléculas de agua que se cargan (oxígenos)
+    bool streamWaters;                  // Aguas de los XYZ leídas por tandas (-stream)
+
+    // Checkpoint: histogramas combinados y números de los frames ya
+    // procesados, escritos cada checkpointInterval frames y al terminar
+    std::string checkpointFile;         // Vacío: sin checkpoint
+    size_t checkpointInterval;
+    int checkpointedFrames;             // processedFrames en el último checkpoint
+    std::set<int> doneFrames;           // Protegido por doneMutex
+    std::mutex doneMutex;
+
+    Metrics metrics;                    // Tiempos por etapa y bytes leídos
+    double progressInterval;            // Segundos entre reportes de avance (0: sin reporte)
+    FrameRange frameRange;              // Frames de esta corrida (-begin/-end/-stride/-shard)
+    std::string manifestFile;           // Índice de pares del directorio (vacío: sin índice)
+    std::optional<std::filesystem::file_time_type> listedTime; // Fecha del directorio al listar los pares (con índice)
+    std::vector<std::vector<size_t>> nodeWorkers; // Workers de cada nodo NUMA (sólo con afinidad)
+
+    bool isFrameDone(int frameNumber);
+    void mergeHistograms();
+    // Un histograma por parámetro (mismos bins) en filename, en archivos
+    // por parámetro o, si combined, en uno solo (ver saveHistogram)
+    void writeHistograms(const std::string& filename, std::span<const Histogram1D> set, bool combined);
+    void writeCheckpoint();
+    // Estado acumulado (formato del checkpoint) en filename, vía temporal
+    void writeState(const std::string& filename);
+    void writeState(std::ostream& out);
+    // Combina un estado guardado con el actual; falla si algún frame ya
+    // estaba incluido. Devuelve cuántos frames tenía. source nombra el
+    // origen en los mensajes de error.
+    size_t loadState(const std::string& filename);
+    size_t loadState(std::istream& in, const std::string& source);
+    // Con el pool quieto (lo espera), combina y escribe si ya toca
+    void checkpointIfDue();
+
+    // Lee el frame de posición index en frame; devuelve false si no quedan
+    using FrameReader = std::function<bool(size_t index, FrameData& frame)>;
+    // Archivo de aguas de un frame leído sin ellas (streamWaters)
+    using WaterSource = std::function<const std::string&(const FrameData& frame)>;
+
+    // Pipeline productor/consumidor: readers hilos lectores llenan un anillo
+    // de framesInFlight buffers y el pool los procesa. Los lectores esperan
+    // cuando no hay buffers libres, así la memoria no crece con la cantidad
+    // de frames. Con skipErrors un frame ilegible se informa y se saltea;
+    // si no, el error se propaga al terminar. Con waterSource, los frames
+    // llegan sólo con la proteína y sus aguas se leen en el worker.
+    void runPipeline(const FrameReader& read, size_t readers, bool skipErrors,
+                     const WaterSource& waterSource = nullptr);
+
+    // Ancho aproximado de las celdas de la grilla (Å)
+    static constexpr double cellSize = 4.0;
     
-    double calculateMinDistance(const WaterMolecule& water, 
-                               const std::vector<ProteinAtom>& proteinAtoms,
-                               double Lx, double Ly, double Lz);
+    // Búsqueda por fuerza bruta: recorre los numAtoms átomos (en precisión
+    // Real) para cada agua
+    template <typename Real>
+    void calculateMinDistances(const Real* ax, const Real* ay, const Real* az, size_t numAtoms,
+                               const double* wx, const double* wy, const double* wz,
+                               size_t numWaters, const PeriodicBox& box, double* minDist);
     
-    FrameData readProteinFile(const std::string& filename, int frameNumber);
-    void readWaterFile(const std::string& filename, FrameData& frame);
+    // Oxígenos a analizar en bloques de como máximo este tamaño
+    static constexpr size_t waterChunk = 16384;
+    // Tanda de aguas leídas a la vez con streamWaters: sus coordenadas,
+    // BOP y distancias (~256 KB) caben en la caché L2
+    static constexpr size_t streamChunk = 4096;
+
+    // Estado de un frame compartido por sus bloques de aguas
+    struct FrameWork {
+        FrameView frame;
+        PeriodicBox box;
+        std::optional<CellList<double>> cells;      // Vacío en fuerza bruta o en float
+        std::optional<CellList<float>> cellsFloat;  // Grilla con Precision::Float
+        std::vector<float> atomX, atomY, atomZ;     // Proteína para la fuerza bruta en float
+        bool useVerlet = false;               // Distancias desde la lista de Verlet
+        BlockAverages::FrameBins frameBins;   // Sumas del frame para los bloques
+        std::mutex binsMutex;
+        std::atomic<size_t> remaining{0};     // Bloques sin terminar
+        std::atomic<bool> failed{false};
+        std::function<void(bool ok)> release; // Se llama al terminar el frame
+
+        explicit FrameWork(const FrameView& f)
+            : frame(f), box(f.Lx, f.Ly, f.Lz, f.xy, f.xz, f.yz) {}
+    };
+
+    // Distancias y acumulación en el histograma para un frame ya leído.
+    // Debe llamarse desde un worker del pool y puede terminar en otro:
+    // release se llama cuando los arreglos del frame ya no se usan, después
+    // de reportarlo, con ok en false si el frame falló y no se contó.
+    void analyzeFrame(const FrameView& frame, std::function<void(bool ok)> release);
+    // Lo mismo para un frame con sólo la proteína: las aguas de waterFile
+    // se parsean, se buscan y se acumulan por tandas, en este worker
+    void analyzeStreamedFrame(const FrameData& frame, const std::string& waterFile,
+                              std::function<void(bool ok)> release);
+    // Caja, grilla (o lista de Verlet) y proteína en float del frame
+    std::shared_ptr<FrameWork> prepareFrame(const FrameView& frame);
+    void analyzeChunk(FrameWork& work, size_t begin, size_t end);
+    // Distancias mínimas de count aguas, sin lista de Verlet
+    void searchWaters(FrameWork& work, const double* wx, const double* wy, const double* wz,
+                      size_t count, double* distances);
+    // Acumula las distancias con los BOP de las mismas aguas (desde offset
+    // en cada columna) en los histogramas y en las sumas del frame
+    void binWaters(FrameWork& work, std::span<const double> distances,
+                   const std::array<std::span<const double>, 4>& parameters, size_t offset);
+    // Suma el frame a los bloques, lo reporta y llama a release
+    void finishFrame(FrameWork& work);
+    void reportFrameDone(int frameNumber);
+
+    // Mapea (o, si está comprimido, descomprime) filename y lo parsea con
+    // parse; readXyzFile lo mide como lectura
+    void readXyzFile(const std::string& filename, const std::function<void(XyzParser&)>& parse);
+    void withXyzFile(const std::string& filename, const std::function<void(XyzParser&)>& parse);
+    // Sólo se guardan los átomos de keep
+    void readProteinFile(const std::string& filename, FrameData& frame, const ElementMask& keep);
+    void readWaterFile(const std::string& filename, FrameData& frame, const ElementMask& keep);
     
-    // Métodos para explorar el directorio
-    std::vector<std::pair<int, std::string>> findProteinFiles(const std::string& directory);
-    std::vector<std::pair<int, std::string>> findWaterFiles(const std::string& directory);
+    // Pares del directorio, del índice si está al día o de una pasada por
+    // el directorio (que renueva el índice)
     std::vector<std::pair<int, std::pair<std::string, std::string>>> findFilePairs(const std::string& directory);
+    // Posiciones de los pares que caen en frameRange
+    std::vector<size_t> selectFrames(
+        const std::vector<std::pair<int, std::pair<std::string, std::string>>>& filePairs) const;
     
 public:
-    ProteinWaterAnalyzer(size_t numThreads, double minDist, double maxDist, int bins);
+    // Las distancias de cada frame se calculan una sola vez y alimentan el
+    // histograma de cada uno de los parámetros de orden indicados.
+    // numThreads debe ser al menos 1 (std::thread::hardware_concurrency()
+    // puede devolver 0); si no, lanza std::invalid_argument.
+    ProteinWaterAnalyzer(size_t numThreads, double minDist, double maxDist, int bins,
+                         const std::vector<int>& parameterIndices,
+                         SearchMode mode = SearchMode::CellList);
     
     void processFrame(int frameNumber, const std::string& proteinFile, 
-                     const std::string& waterFile, int parameterIndex);
+                     const std::string& waterFile);
     
-    // Método actualizado para procesar desde directorio
-    void processDirectory(const std::string& directory, int parameterIndex);
+    // Activa la lista de Verlet con la piel indicada (Å; 0 la desactiva).
+    // Los frames de processDirectory/processTrajectory se procesan entonces
+    // en orden, de a uno, repartiendo sus aguas entre los workers.
+    void setSkin(double skin);
+
+    // Precisión de la búsqueda de distancias (por defecto, Double). La
+    // lista de Verlet sólo admite Double.
+    void setPrecision(Precision p);
+
+    // Fija los workers a CPUs según spec (compact, scatter o una lista de
+    // CPUs, ver Topology; "none" no cambia nada). Cada worker reserva sus
+    // shards y buffers en la memoria de su nodo y, al combinar, los shards
+    // de cada nodo se pliegan primero en un worker de ese nodo. Devuelve
+    // cuántos nodos NUMA quedan ocupados.
+    size_t setAffinity(const std::string& spec);
+
+    // Lee las aguas de los archivos XYZ por tandas en el worker que las
+    // analiza, sin armar el arreglo de aguas del frame: la memoria por
+    // frame ya no crece con la cantidad de aguas. Cada frame lo procesa un
+    // solo worker. No se combina con la lista de Verlet; el caché y las
+    // trayectorias concatenadas se leen como siempre.
+    void setStreamWaters(bool stream);
+
+    // Acumula además, en la misma pasada, un histograma conjunto distancia ×
+    // parámetro con parameterBins bins en range (por defecto, bopRange de
+    // cada parámetro)
+    void enableJointHistogram(int parameterBins,
+                              std::optional<std::pair<double, double>> range = std::nullopt);
+
+    // Acumula además, con las mismas distancias, un histograma por
+    // parámetro con los bins de binning (uniformes o arbitrarios). Puede
+    // llamarse varias veces; la búsqueda llega hasta el mayor de los
+    // máximos.
+    void addBinning(const Binning& binning);
+
+    // Acumula además promedios por bloques de blockSize frames consecutivos
+    // (0: sin bloques) y, si series, la serie temporal de cada frame
+    void enableBlockAverages(size_t blockSize, bool series);
+
+    // Elementos que se cargan de la proteína (por defecto todos) y de las
+    // aguas (por defecto sólo O). El resto se descarta al leer cada frame.
+    void setSelection(const ElementMask& protein, const ElementMask& water);
+
+    // Escribe un checkpoint en file cada interval frames procesados y al
+    // terminar (wait). Para escribirlo se espera a que el pool quede quieto.
+    void setCheckpoint(const std::string& file, size_t interval);
+
+    // Carga el checkpoint de setCheckpoint, si existe: los histogramas
+    // continúan desde su estado y los frames ya procesados se saltean en
+    // processDirectory/processTrajectory. Devuelve cuántos frames tenía.
+    size_t resume();
+
+    // Cantidad de hilos lectores y de frames en memoria a la vez
+    void setPipeline(size_t readers, size_t inFlight);
+
+    // Índice de los pares del directorio que usan processDirectory y
+    // convertDirectory (vacío: recorrer siempre el directorio)
+    void setManifest(const std::string& file);
+
+    // Restringe los frames de processDirectory (y, salvo shard, de
+    // processTrajectory). Las posiciones de los bloques siguen siendo las
+    // de la trayectoria completa, así los resultados parciales se combinan.
+    void setFrameRange(const FrameRange& range);
+
+    // Resultado parcial: el estado acumulado en bruto (conteos, medias y
+    // sumas de cuadrados por bin, bloques y frames incluidos), en el formato
+    // del checkpoint. Llamar después de wait().
+    void writePartial(const std::string& filename);
+
+    // Suma un resultado parcial al estado actual (bop-merge). Falla si los
+    // parámetros o los bins no coinciden o si un frame ya estaba incluido.
+    size_t mergePartial(const std::string& filename);
+
+    // Analizador vacío con la configuración (parámetros, bins, -2d, -block)
+    // del resultado parcial filename, para combinar parciales
+    static std::unique_ptr<ProteinWaterAnalyzer> fromPartial(const std::string& filename,
+                                                             size_t numThreads = 1);
+
+    // Muestra el avance (frames/s y tiempo restante) cada seconds segundos
+    // mientras se procesa; 0 lo desactiva
+    void setProgressInterval(double seconds);
+
+    // Escribe las métricas de la corrida (tiempo por etapa, CPU, memoria
+    // máxima, bytes leídos) en un archivo JSON
+    void writeMetrics(const std::string& filename);
+
+    // Método actualizado para procesar desde directorio. Si cacheFile no
+    // está vacío y el caché está al día, los frames se leen de él.
+    void processDirectory(const std::string& directory, const std::string& cacheFile = "");
+
+    // Procesa una trayectoria de proteína y una de aguas con varios frames
+    // concatenados cada una. Los frames se leen en secuencia y se entregan
+    // al pool a medida que se decodifican, con un máximo de frames en memoria.
+    // Cada frame toma el número de su línea de comentario ("frame=N") o, si
+    // no lo tiene, su posición en la trayectoria (desde 0).
+    void processTrajectory(const std::string& proteinFile, const std::string& waterFile);
+
+    // Análisis en memoria (libboppdf): acumula un frame cuyos arreglos son
+    // de quien llama, sin copiarlos. Las aguas se reparten entre los
+    // workers como en processDirectory y la llamada vuelve cuando el frame
+    // ya está en los histogramas, así los arreglos pueden reutilizarse.
+    // Falla si los tamaños no coinciden o si el frame no pudo procesarse.
+    // Los frames deben llegar de a uno (con la lista de Verlet, en orden).
+    void accumulate(const FrameView& frame);
+
+    // Suma al estado actual lo acumulado por other (por ejemplo, el
+    // analizador de otro hilo o de otro rango de frames); esperan ambos a
+    // sus tareas. Falla como mergePartial si la configuración no coincide
+    // o si un frame ya estaba incluido.
+    size_t merge(ProteinWaterAnalyzer& other);
+
+    // Espera las tareas (como wait) y devuelve el histograma de cada
+    // parámetro, en el orden de parameterIndices
+    std::vector<HistogramResult> finalize();
+
+    // Convierte el directorio a un caché binario (subcomando convert)
+    void convertDirectory(const std::string& directory, const std::string& cacheFile,
+                          bool singlePrecision);
 
     // Espera a que terminen todas las tareas en el thread pool
     void wait();
     
-    void saveHistogram(const std::string& filename);
+    // Con un solo parámetro escribe filename; con varios, un archivo por
+    // parámetro (histograma-Q4.dat, ...) o, si combined, uno solo con
+    // todas las columnas. Los histogramas conjuntos, los bloques y las
+    // series van siempre a un archivo por parámetro (histograma-2d-Q6.dat,
+    // histograma-blocks-Q6.dat, histograma-series-Q6.dat). El esquema de
+    // bins adicional k (addBinning, desde 1) va, de la misma manera, a
+    // histograma-binning<k>.dat (histograma-binning<k>-Q6.dat, ...).
+    void saveHistogram(const std::string& filename, bool combined = false);
     void printStatistics();
 };
 
@@ -3,7 +3,7 @@
 
 #include <vector>
 #include <thread>
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <future>
@@ -12,25 +12,72 @@
 #include <stdexcept>
 #include <memory>
 
+// Pool con robo de trabajo: cada worker tiene su propia cola. Las tareas
+// encoladas desde un worker van a su cola (se toman en orden LIFO, con los
+// datos todavía en caché) y los workers ociosos roban de las colas ajenas
+// por el otro extremo. Las tareas encoladas desde fuera del pool se
+// reparten entre las colas en round-robin.
 class ThreadPool {
 private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::deque<std::function<void()>> owned;  // Sólo para este worker (enqueueOn)
+    };
+
     std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<size_t> nextQueue;      // Round-robin para tareas externas
+
+    // Los workers sin trabajo duermen aquí hasta que haya tareas encoladas
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> queuedTasks;    // Tareas en colas, sin tomar
 
-    std::mutex queueMutex;
-    std::condition_variable condition;
-    std::condition_variable finished;
+    // Contador de finalización: tareas encoladas y no terminadas. Sólo se
+    // notifica a wait() cuando llega a cero.
+    std::mutex doneMutex;
+    std::condition_variable allDone;
+    std::atomic<size_t> pendingTasks;
 
     std::atomic<bool> stop;
-    std::atomic<int> activeTasks;
+
+    // Índice del worker que ejecuta el hilo actual (-1 fuera del pool)
+    static thread_local int currentWorker;
+
+    // owner >= 0: la tarea va a la cola propia de ese worker y no se roba
+    void push(std::function<void()> task, int owner = -1);
+    bool popLocal(size_t worker, std::function<void()>& task);
+    bool steal(size_t thief, std::function<void()>& task);
+    void workerLoop(size_t worker);
+    void taskFinished();
 
 public:
+    // numThreads >= 1; con 0 lanza std::invalid_argument
     ThreadPool(size_t numThreads);
 
+    size_t size() const { return workers.size(); }
+
+    // Índice [0, size()) del worker actual, o -1 si el hilo no es del pool.
+    // Permite que cada worker use su propio acumulador sin sincronización.
+    static int workerIndex() { return currentWorker; }
+
     template<class F>
     auto enqueue(F&& f) -> std::future<decltype(f())>;
 
-    // Espera hasta que no haya tareas pendientes ni activas
+    // Encola f para que la ejecute sólo el worker indicado (por ejemplo,
+    // para trabajar sobre memoria de su nodo NUMA). Pensado para el pool
+    // quieto: mientras la tarea espera a su worker, los demás no duermen.
+    template<class F>
+    auto enqueueOn(size_t worker, F&& f) -> std::future<decltype(f())>;
+
+    // Fija cada worker i a la CPU cpus[i] (sched_setaffinity). Lo que un
+    // worker reserve y escriba primero queda después en la memoria de su
+    // nodo NUMA. Falla si el sistema rechaza alguna CPU.
+    void pin(const std::vector<int>& cpus);
+
+    // Espera hasta que no haya tareas pendientes ni activas, incluidas las
+    // que encolen las propias tareas. No debe llamarse desde un worker.
     void wait();
 
     ~ThreadPool();
@@ -43,27 +90,27 @@ auto ThreadPool::enqueue(F&& f) -> std::future<decltype(f())> {
     auto taskPtr = std::make_shared<std::packaged_task<return_type()>>(std::forward<F>(f));
     std::future<return_type> res = taskPtr->get_future();
 
-    {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        if (stop) {
-            throw std::runtime_error("enqueue on stopped ThreadPool");
-        }
-
-        tasks.emplace([taskPtr, this]() {
-            activeTasks.fetch_add(1, std::memory_order_relaxed);
-            try {
-                (*taskPtr)();
-            } catch (...) {
-                activeTasks.fetch_sub(1, std::memory_order_relaxed);
-                finished.notify_all();
-                throw;
-            }
-            activeTasks.fetch_sub(1, std::memory_order_relaxed);
-            finished.notify_all();
-        });
+    if (stop.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+
+    // packaged_task guarda las excepciones en el future
+    push([taskPtr]() { (*taskPtr)(); });
+    return res;
+}
+
+template<class F>
+auto ThreadPool::enqueueOn(size_t worker, F&& f) -> std::future<decltype(f())> {
+    using return_type = decltype(f());
+
+    auto taskPtr = std::make_shared<std::packaged_task<return_type()>>(std::forward<F>(f));
+    std::future<return_type> res = taskPtr->get_future();
+
+    if (stop.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("enqueue on stopped ThreadPool");
     }
 
-    condition.notify_one();
+    push([taskPtr]() { (*taskPtr)(); }, static_cast<int>(worker % workers.size()));
     return res;
 }
 
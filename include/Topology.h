@@ -0,0 +1,37 @@
+// include/Topology.h
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Nodos NUMA de la máquina y las CPUs de cada uno, leídos de sysfs
+// (/sys/devices/system/node). Sólo se consideran las CPUs en las que el
+// proceso puede correr; sin información de NUMA hay un único nodo.
+class Topology {
+private:
+    std::vector<std::vector<int>> nodes;  // CPUs de cada nodo, en orden
+    std::vector<int> nodeOfCpu;           // -1: CPU no disponible
+
+public:
+    explicit Topology(const std::string& sysfsRoot = "/sys/devices/system/node");
+
+    size_t numNodes() const { return nodes.size(); }
+    const std::vector<int>& cpusOf(size_t node) const { return nodes[node]; }
+
+    // Nodo de cpu, o -1 si no es una CPU disponible
+    int nodeOf(int cpu) const;
+
+    // CPU de cada uno de numWorkers workers según spec: "compact" llena
+    // un nodo antes de pasar al siguiente, "scatter" reparte los workers
+    // entre los nodos en round-robin y una lista como "0-15,32-47" los
+    // asigna en ese orden. Con más workers que CPUs se vuelve a empezar.
+    // Falla si spec no es válido o nombra una CPU no disponible.
+    std::vector<int> placement(std::string_view spec, size_t numWorkers) const;
+
+    // Lista de CPUs "0-3,8,10-11"
+    static std::vector<int> parseCpuList(std::string_view list);
+};
+
+#endif
@@ -0,0 +1,59 @@
+// include/TrajectoryReader.h
+#ifndef TRAJECTORYREADER_H
+#define TRAJECTORYREADER_H
+
+#include "Types.h"
+#include "CompressedInput.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Lector secuencial de una trayectoria XYZ con varios frames concatenados.
+// Lee el archivo por bloques y detecta los límites de cada frame a partir
+// de la cantidad de átomos de su encabezado, de modo que en memoria sólo
+// hay un frame (más un bloque de lectura) a la vez. Los archivos .gz y .zst
+// se descomprimen al leerlos, en un hilo aparte.
+class TrajectoryReader {
+public:
+    enum class Kind {
+        Protein,  // frame_XXX.xyz concatenados
+        Water     // frame_XXX_bop.xyz concatenados
+    };
+
+private:
+    std::string filename;
+    Kind kind;
+    ElementMask keep;              // Átomos o moléculas que se guardan
+    std::unique_ptr<InputStream> input;
+    std::vector<char> buffer;
+    size_t dataBegin, dataEnd;     // Rango válido dentro de buffer
+    bool eof;
+    size_t lineNumber;             // Líneas consumidas hasta dataBegin
+    uint64_t totalBytes;           // Bytes leídos (descomprimidos)
+    std::optional<int> lastCommentFrame;
+
+    bool fill();
+    const char* findFrameEnd(const char* begin, const char* end) const;
+
+public:
+    static constexpr size_t chunkSize = 4 << 20;
+
+    TrajectoryReader(const std::string& filename, Kind kind, ElementMask keep = ElementMask::all());
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    // Lee el próximo frame en frame (proteína o aguas según el tipo).
+    // Devuelve false al llegar al final del archivo.
+    bool readFrame(FrameData& frame);
+
+    // Número de frame indicado en la línea de comentario ("frame=N") del
+    // último frame leído, si lo había
+    std::optional<int> commentFrameNumber() const { return lastCommentFrame; }
+
+    uint64_t bytesRead() const { return totalBytes; }
+};
+
+#endif
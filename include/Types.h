@@ -2,40 +2,156 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-// Clase para representar un átomo de la proteína
-class ProteinAtom {
+// Identificador de un elemento en la tabla compartida
+using ElementId = uint8_t;
+
+// Tabla de elementos internados, única para todo el proceso: cada nombre
+// ("O", "C", ...) recibe un identificador pequeño la primera vez que
+// aparece y los átomos guardan sólo ese identificador. Es segura entre
+// hilos; buscar un elemento ya conocido no toma ningún lock.
+class ElementTable {
 public:
-    std::string element;
-    double x, y, z;
-    
-    ProteinAtom(const std::string& elem, double x_, double y_, double z_)
-        : element(elem), x(x_), y(y_), z(z_) {}
+    static constexpr size_t maxElements = 256;
+
+    // Identificador de name, agregándolo si es nuevo
+    static ElementId intern(std::string_view name);
+    static const std::string& name(ElementId id);
+    static size_t size();
 };
 
-// Clase para representar una molécula de agua
-class WaterMolecule {
+// Selección de elementos (un bit por identificador) precompilada a partir
+// de un texto como "all", "heavy" o "C,N,O"
+class ElementMask {
+private:
+    std::bitset<ElementTable::maxElements> bits;
+
 public:
-    std::string element;
-    double x, y, z;
-    double Q4, Q6, W4, W6;
-    
-    WaterMolecule(const std::string& elem, double x_, double y_, double z_,
-                  double q4_, double q6_, double w4_, double w6_)
-        : element(elem), x(x_), y(y_), z(z_), Q4(q4_), Q6(q6_), W4(w4_), W6(w6_) {}
+    static ElementMask all();
+
+    // "all": todos; "heavy": todos menos H; si no, lista separada por comas
+    static ElementMask parse(std::string_view spec);
+
+    bool contains(ElementId id) const { return bits.test(id); }
+    bool isAll() const { return bits.all(); }
+};
+
+// Coordenadas SoA sin copia: vistas sobre los arreglos de ProteinAtoms o
+// WaterMolecules, o sobre la memoria de un programa que embebe libboppdf
+struct PositionsView {
+    std::span<const double> x, y, z;
+
+    size_t size() const { return x.size(); }
+};
+
+// Átomos de la proteína de un frame en formato SoA (structure of arrays):
+// cada coordenada es un arreglo contiguo que el núcleo de distancias
+// recorre sin saltar sobre el resto de los campos
+class ProteinAtoms {
+public:
+    std::vector<ElementId> element;
+    std::vector<double> x, y, z;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    PositionsView positions() const { return {x, y, z}; }
+
+    // Conserva la capacidad, así un buffer reutilizado no vuelve a reservar
+    void resize(size_t n) {
+        element.resize(n);
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+    }
+};
+
+// Moléculas de agua de un frame (posición del átomo y sus BOP) en formato SoA
+class WaterMolecules {
+public:
+    std::vector<ElementId> element;
+    std::vector<double> x, y, z;
+    std::vector<double> Q4, Q6, W4, W6;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    PositionsView positions() const { return {x, y, z}; }
+
+    // Columna del parámetro de orden según su índice (1-4: Q4, Q6, W4, W6)
+    const std::vector<double>& parameter(int parameterIndex) const {
+        switch (parameterIndex) {
+            case 1: return Q4;
+            case 3: return W4;
+            case 4: return W6;
+            default: return Q6;
+        }
+    }
+
+    void resize(size_t n) {
+        element.resize(n);
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        Q4.resize(n);
+        Q6.resize(n);
+        W4.resize(n);
+        W6.resize(n);
+    }
+};
+
+// Nombre del parámetro de orden según su índice (1-4: Q4, Q6, W4, W6)
+inline const char* bopName(int parameterIndex) {
+    static const char* names[] = {"Q4", "Q6", "W4", "W6"};
+    return names[parameterIndex - 1];
+}
+
+// Rango habitual del parámetro de orden: [0, 1] para Q4/Q6 y [-0.2, 0.2]
+// para W4/W6
+inline std::pair<double, double> bopRange(int parameterIndex) {
+    return parameterIndex <= 2 ? std::pair(0.0, 1.0) : std::pair(-0.2, 0.2);
+}
+
+// Frame sin copia, tal como lo entrega un programa que ya tiene las
+// coordenadas en memoria (ProteinWaterAnalyzer::accumulate). waters son
+// los puntos ya seleccionados (normalmente los oxígenos) y parameters sus
+// columnas de BOP por índice - 1 (Q4, Q6, W4, W6); las de los parámetros
+// que no se analizan pueden quedar vacías.
+struct FrameView {
+    int frameNumber = 0;
+    size_t sequence = 0;  // Posición del frame en la trayectoria (bloques)
+    PositionsView protein;
+    PositionsView waters;
+    std::array<std::span<const double>, 4> parameters;
+    double Lx = 0, Ly = 0, Lz = 0;  // 0: sin caja periódica
+    double xy = 0, xz = 0, yz = 0;  // Factores de inclinación de una caja triclínica
 };
 
 // Clase para representar un frame completo
 class FrameData {
 public:
     int frameNumber;
-    std::vector<ProteinAtom> proteinAtoms;
-    std::vector<WaterMolecule> waterMolecules;
-    double Lx, Ly, Lz;
+    ProteinAtoms proteinAtoms;
+    WaterMolecules waterMolecules;
+    double Lx, Ly, Lz;  // 0: sin caja periódica
+    double xy, xz, yz;  // Factores de inclinación de una caja triclínica
+    size_t sequence;    // Posición del frame en la trayectoria ordenada (bloques)
     
-    FrameData(int frame) : frameNumber(frame), Lx(0), Ly(0), Lz(0) {}
+    FrameData(int frame)
+        : frameNumber(frame), Lx(0), Ly(0), Lz(0), xy(0), xz(0), yz(0), sequence(0) {}
+
+    // Vista sobre los arreglos del frame, válida mientras no se modifique
+    FrameView view() const {
+        const WaterMolecules& w = waterMolecules;
+        return {frameNumber, sequence, proteinAtoms.positions(), w.positions(),
+                {w.Q4, w.Q6, w.W4, w.W6}, Lx, Ly, Lz, xy, xz, yz};
+    }
 };
 
 #endif
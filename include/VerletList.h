@@ -0,0 +1,65 @@
+// include/VerletList.h
+#ifndef VERLETLIST_H
+#define VERLETLIST_H
+
+#include "Types.h"
+#include "CellList.h"
+#include "DistanceKernel.h"
+#include <atomic>
+#include <vector>
+
+// Lista de vecinos con piel (Verlet skin) reutilizada entre frames
+// consecutivos. Para cada agua guarda los átomos de proteína a menos de
+// d + skin de su posición, donde d era su distancia mínima al armar la
+// lista; las aguas a más de maxDistance + skin no guardan candidatos y
+// quedan fuera del histograma sin recorrer nada. Mientras el desplazamiento del agua más el de
+// la proteína desde entonces no supere skin/2, el átomo más cercano está
+// entre esos candidatos y basta con recorrerlos. Las aguas que salen de su
+// región vuelven a la búsqueda completa en la grilla y renuevan su lista.
+// Los frames deben llegar en orden y de a uno.
+class VerletList {
+private:
+    struct WaterEntry {
+        double x0, y0, z0;        // Posición al armar la lista
+        double atomShift0;        // Desplazamiento de la proteína en ese momento
+        bool far;                 // Sin átomos a menos de maxDistance + skin
+        std::vector<int> candidates;
+    };
+
+    double skin;
+    bool valid;                   // false: hay que reconstruir todo
+    PeriodicBox box;
+    std::vector<double> atomX0, atomY0, atomZ0;  // Proteína en la reconstrucción
+    double atomShift;             // Desplazamiento máximo de la proteína desde entonces
+    std::vector<WaterEntry> waters;
+    std::vector<char> needsSearch;               // Aguas a buscar en la grilla este frame
+    MinDistance2Kernel<double> kernel;
+
+    std::atomic<size_t> reusedWaters;
+    std::atomic<size_t> searchedWaters;
+
+    double displacement(double x, double y, double z, double x0, double y0, double z0) const;
+
+public:
+    explicit VerletList(double skin);
+
+    // Prepara un frame: reconstruye todo si cambió la caja, la cantidad de
+    // átomos o de aguas, o si la proteína se movió más de skin/2, y marca
+    // las aguas que necesitan búsqueda completa. Devuelve cuántas son (si
+    // no hay ninguna, no hace falta armar la grilla).
+    size_t beginFrame(const PositionsView& atoms, const PeriodicBox& box,
+                      const double* wx, const double* wy, const double* wz, size_t numWaters);
+
+    // Distancias mínimas de las aguas [begin, end) del frame preparado.
+    // cells sólo se usa para las aguas marcadas. Rangos disjuntos pueden
+    // calcularse en paralelo.
+    void findMinDistances(const PositionsView& atoms, const CellList<double>* cells,
+                          const double* wx, const double* wy, const double* wz,
+                          size_t begin, size_t end, double maxDistance, double* minDist);
+
+    double getSkin() const { return skin; }
+    size_t getReusedWaters() const { return reusedWaters; }
+    size_t getSearchedWaters() const { return searchedWaters; }
+};
+
+#endif
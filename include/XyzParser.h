@@ -0,0 +1,73 @@
+// include/XyzParser.h
+#ifndef XYZPARSER_H
+#define XYZPARSER_H
+
+#include "Types.h"
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Parser de archivos XYZ sobre un buffer en memoria (normalmente un archivo
+// mapeado). Los números se leen con std::from_chars, sin locale ni copias,
+// y se escriben directamente en los arreglos del frame. Los errores se
+// reportan con el nombre del archivo y el número de línea.
+class XyzParser {
+private:
+    const char* pos;
+    const char* end;
+    std::string source;
+    size_t lineNumber;
+    std::optional<int> commentFrame;
+    std::string_view lastElement;  // Último elemento internado y su identificador
+    ElementId lastElementId;
+    size_t waterCount;             // Moléculas del frame de aguas en curso
+    size_t watersRead;             // Registros ya leídos de ese frame
+    size_t waterHeaderLine;
+
+    bool nextLine(std::string_view& line);
+    bool nextNonBlankLine(std::string_view& line);
+    size_t parseCount();
+    ElementId internElement(std::string_view name);
+    void parseComment(std::string_view line, FrameData* frame);
+    void parseLattice(std::string_view value, FrameData& frame);
+    [[noreturn]] void fail(const std::string& message) const;
+
+public:
+    // firstLine: líneas ya consumidas antes de begin (para los mensajes de error)
+    XyzParser(const char* begin, const char* end, std::string source, size_t firstLine = 0);
+
+    // true si la línea tiene la forma "elemento x y z Q4 Q6 W4 W6", con un
+    // nombre de elemento (letras, dígitos y '_', comenzando por letra) y
+    // sin campos clave=valor. Decide si la línea siguiente al encabezado de
+    // un frame de aguas es un comentario.
+    static bool isWaterRecord(std::string_view line);
+
+    // Número de frame indicado en la línea de comentario ("frame=N") del
+    // último frame leído, si lo había
+    std::optional<int> commentFrameNumber() const { return commentFrame; }
+
+    // true si sólo queda espacio en blanco en el buffer
+    bool atEnd();
+
+    // Frame de proteína: cantidad de átomos, línea con Lx= Ly= Lz= (y, si
+    // la caja es triclínica, xy= xz= yz=, o bien Lattice="...") y luego
+    // "elemento x y z" por átomo. Sólo se guardan los átomos de keep.
+    void parseProteinFrame(FrameData& frame, const ElementMask& keep = ElementMask::all());
+
+    // Frame de aguas: cantidad de moléculas, línea de comentario opcional y
+    // luego "elemento x y z Q4 Q6 W4 W6" por molécula. Sólo se guardan las
+    // moléculas de keep. El buffer debe terminar con el frame: un registro
+    // más allá de la cantidad del encabezado es un error (un comentario
+    // que parece un registro, ver isWaterRecord).
+    void parseWaterFrame(FrameData& frame, const ElementMask& keep = ElementMask::all());
+
+    // El mismo frame de aguas, por tandas: beginWaterFrame lee el
+    // encabezado y cada nextWaters deja en chunk (reemplazando su
+    // contenido, sin perder la capacidad) las próximas moléculas de keep,
+    // hasta maxMolecules. Devuelve false cuando el frame ya no tiene más.
+    void beginWaterFrame();
+    bool nextWaters(WaterMolecules& chunk, size_t maxMolecules,
+                    const ElementMask& keep = ElementMask::all());
+};
+
+#endif
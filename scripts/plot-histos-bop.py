@@ -28,6 +28,7 @@ Ejemplos de uso:
   python script.py --directorio datos/ --minimo 0.5 --maximo 15.0 --parametro Q4
   python script.py -d resultados/ -min 1.0 -max 10.0 -p W6
   python script.py  # Usa todos los valores por defecto
+  python script.py -d resultados/ --dist2d  # Mapas P(BOP | r) de los archivos *-2d-*.dat
         '''
     )
     
@@ -61,6 +62,12 @@ Ejemplos de uso:
         help='Parámetro de orden: Q4, Q6, W4, W6 (por defecto: Q6)'
     )
     
+    parser.add_argument(
+        '--dist2d',
+        action='store_true',
+        help='Graficar la distribución P(parámetro | r) de los archivos *-2d-*.dat'
+    )
+
     # Parsear los argumentos
     args = parser.parse_args()
     
@@ -87,7 +94,11 @@ Ejemplos de uso:
     print(f"Directorio de salida: {args.directorio}")
     
 
-    files = glob.glob(args.directorio + '/histo-*.dat')
+    if args.dist2d:
+        plot_dist2d(args)
+        return
+
+    files = [f for f in glob.glob(args.directorio + '/histo-*.dat') if '-2d-' not in f]
     files.sort()
     print(files)
     for file in files:
@@ -105,5 +116,37 @@ Ejemplos de uso:
 
 
 
+def load_dist2d(file):
+    # Segunda línea de comentario: '# <parámetro> centros de sus bins'
+    with open(file) as f:
+        f.readline()
+        header = f.readline().split()
+    name, centers = header[1], np.array(header[2:], dtype=float)
+    data = np.loadtxt(file)
+    return name, data[:, 0], centers, data[:, 1:]
+
+
+def plot_dist2d(args):
+    files = glob.glob(args.directorio + '/*-2d-*.dat')
+    files.sort()
+    print(files)
+    for file in files:
+        name, r, centers, counts = load_dist2d(file)
+        # Normalizar cada fila: distribución del parámetro a distancia fija
+        totals = counts.sum(axis=1, keepdims=True)
+        width = centers[1] - centers[0] if len(centers) > 1 else 1.0
+        density = np.divide(counts, totals * width, out=np.zeros_like(counts), where=totals > 0)
+        plt.figure()
+        plt.pcolormesh(r, centers, density.T, shading='nearest')
+        plt.colorbar(label=f'$P({name}\\mid r)$')
+        plt.xlim([args.minimo, args.maximo])
+        plt.xlabel(r'$r$ [A]')
+        plt.ylabel(name)
+        plt.tight_layout()
+        output = os.path.splitext(os.path.basename(file))[0] + '.pdf'
+        plt.savefig(output)
+        print(f'  {file} -> {output}')
+
+
 if __name__ == "__main__":
     main()
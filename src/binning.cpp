@@ -0,0 +1,150 @@
+// src/binning.cpp
+#include "Binning.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+Binning::Binning(double minDistance, double maxDistance, int numBins)
+    : uniform(true), width((maxDistance - minDistance) / numBins), invCell(0.0) {
+    if (numBins < 1 || !(maxDistance > minDistance)) {
+        throw std::runtime_error("Bins inválidos: se necesita min < max y al menos un bin");
+    }
+    edges.resize(numBins + 1);
+    for (int i = 0; i < numBins; ++i) {
+        edges[i] = minDistance + i * width;
+    }
+    edges[numBins] = maxDistance;
+}
+
+Binning::Binning(std::vector<double> edges_)
+    : edges(std::move(edges_)), uniform(false), width(0.0), invCell(0.0) {
+    if (edges.size() < 2) {
+        throw std::runtime_error("Se necesitan al menos dos bordes de bins");
+    }
+    double minWidth = edges.back() - edges.front();
+    for (size_t i = 0; i + 1 < edges.size(); ++i) {
+        if (!(edges[i + 1] > edges[i]) || !std::isfinite(edges[i + 1])) {
+            throw std::runtime_error("Los bordes de los bins deben ser finitos y estrictamente crecientes");
+        }
+        minWidth = std::min(minWidth, edges[i + 1] - edges[i]);
+    }
+
+    // Celdas no más anchas que el bin más angosto; si eso da demasiadas
+    // celdas, la corrección de tableBin recorre más de un borde
+    const double span = edges.back() - edges.front();
+    const double wanted = std::ceil(span / minWidth);
+    const size_t cells = wanted >= maxTableCells ? maxTableCells
+                                                 : std::max<size_t>(static_cast<size_t>(wanted), 1);
+    invCell = cells / span;
+    table.resize(cells);
+    int bin = 0;
+    for (size_t c = 0; c < cells; ++c) {
+        const double start = edges.front() + c / invCell;
+        while (bin < numBins() - 1 && start >= edges[bin + 1]) {
+            ++bin;
+        }
+        table[c] = bin;
+    }
+}
+
+namespace {
+
+double parseNumber(const std::string& text, const std::string& spec) {
+    size_t used = 0;
+    double value = 0.0;
+    try {
+        value = std::stod(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != text.size()) {
+        throw std::runtime_error("Esquema de bins inválido: '" + spec + "'");
+    }
+    return value;
+}
+
+} // namespace
+
+Binning Binning::parse(const std::string& spec) {
+    std::vector<std::string> fields;
+    std::stringstream stream(spec);
+    for (std::string field; std::getline(stream, field, ':');) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() == 3 || (fields.size() == 4 && fields[0] == "log")) {
+        const size_t first = fields.size() - 3;
+        const double low = parseNumber(fields[first], spec);
+        const double high = parseNumber(fields[first + 1], spec);
+        const double bins = parseNumber(fields[first + 2], spec);
+        if (bins < 1 || bins != std::floor(bins)) {
+            throw std::runtime_error("Esquema de bins inválido: '" + spec + "'");
+        }
+        if (first == 0) {
+            return Binning(low, high, static_cast<int>(bins));
+        }
+        if (!(low > 0) || !(high > low)) {
+            throw std::runtime_error("Los bins logarítmicos necesitan 0 < min < max: '" + spec + "'");
+        }
+        std::vector<double> logEdges(static_cast<size_t>(bins) + 1);
+        const double ratio = std::log(high / low) / bins;
+        for (size_t i = 0; i < logEdges.size(); ++i) {
+            logEdges[i] = low * std::exp(ratio * i);
+        }
+        logEdges.front() = low;
+        logEdges.back() = high;
+        return Binning(std::move(logEdges));
+    }
+
+    std::ifstream file(spec);
+    if (!file.is_open()) {
+        throw std::runtime_error("Esquema de bins inválido (ni min:max:bins ni un archivo legible): '" +
+                                 spec + "'");
+    }
+    std::vector<double> fileEdges;
+    for (std::string line; std::getline(file, line);) {
+        std::stringstream tokens(line.substr(0, line.find('#')));
+        for (std::string token; tokens >> token;) {
+            fileEdges.push_back(parseNumber(token, spec));
+        }
+    }
+    return Binning(std::move(fileEdges));
+}
+
+std::string Binning::describe() const {
+    std::ostringstream out;
+    if (uniform) {
+        out << lower() << "-" << upper() << " Å, " << numBins() << " bins";
+    } else {
+        out << "bordes de " << lower() << " a " << upper() << " Å, " << numBins() << " bins";
+    }
+    return out.str();
+}
+
+void Binning::save(std::ostream& out) const {
+    const uint32_t count = edges.size();
+    const uint8_t isUniform = uniform;
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(&isUniform), sizeof(isUniform));
+    out.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(double));
+}
+
+Binning Binning::load(std::istream& in) {
+    uint32_t count = 0;
+    uint8_t isUniform = 0;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    in.read(reinterpret_cast<char*>(&isUniform), sizeof(isUniform));
+    if (!in || count < 2 || count > (uint32_t(1) << 26)) {
+        throw std::runtime_error("Bordes de bins inválidos en el checkpoint");
+    }
+    std::vector<double> loaded(count);
+    in.read(reinterpret_cast<char*>(loaded.data()), loaded.size() * sizeof(double));
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado");
+    }
+    if (isUniform) {
+        return Binning(loaded.front(), loaded.back(), static_cast<int>(count - 1));
+    }
+    return Binning(std::move(loaded));
+}
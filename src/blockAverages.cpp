@@ -0,0 +1,162 @@
+// src/blockAverages.cpp
+#include "BlockAverages.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+BlockAverages::BlockAverages(double minDist, double maxDist, int bins, size_t numParameters_,
+                             size_t blockSize_, bool keepSeries_)
+    : minDistance(minDist), maxDistance(maxDist),
+      numBins(bins), binWidth((maxDist - minDist) / bins),
+      numParameters(numParameters_), blockSize(blockSize_), keepSeries(keepSeries_) {}
+
+BlockAverages::FrameBins BlockAverages::emptyFrame() const {
+    FrameBins frame;
+    frame.sum.assign(numParameters * numBins, 0.0);
+    frame.count.assign(numParameters * numBins, 0);
+    return frame;
+}
+
+void BlockAverages::accumulate(FrameBins& frame, size_t parameter, std::span<const double> distances,
+                               std::span<const double> parameters) const {
+    double* sum = frame.sum.data() + parameter * numBins;
+    long long* count = frame.count.data() + parameter * numBins;
+    for (size_t i = 0; i < distances.size(); ++i) {
+        const double distance = distances[i];
+        if (!(distance >= minDistance && distance <= maxDistance)) {
+            continue;
+        }
+        const int bin = std::min(static_cast<int>((distance - minDistance) / binWidth), numBins - 1);
+        sum[bin] += parameters[i];
+        count[bin]++;
+    }
+}
+
+void BlockAverages::addFrame(size_t sequence, int frameNumber, const FrameBins& frame) {
+    std::vector<float> averages;
+    if (keepSeries) {
+        averages.resize(frame.sum.size());
+        for (size_t k = 0; k < averages.size(); ++k) {
+            averages[k] = frame.count[k] > 0 ? static_cast<float>(frame.sum[k] / frame.count[k])
+                                             : std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (blockSize > 0) {
+        auto [it, inserted] = blocks.try_emplace(sequence / blockSize);
+        FrameBins& block = it->second;
+        if (inserted) {
+            block = emptyFrame();
+        }
+        for (size_t k = 0; k < frame.sum.size(); ++k) {
+            block.sum[k] += frame.sum[k];
+            block.count[k] += frame.count[k];
+        }
+    }
+    if (keepSeries) {
+        series[sequence] = {frameNumber, std::move(averages)};
+    }
+}
+
+void BlockAverages::saveBlocks(const std::string& filename, size_t parameter,
+                               const std::string& name) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
+        return;
+    }
+
+    file << "# Promedios de " << name << " en bloques de " << blockSize << " frames ("
+         << blocks.size() << " bloques)\n";
+    file << "# r avg_" << name << " sem_" << name << " nblocks\n";
+
+    for (int i = 0; i < numBins; ++i) {
+        const size_t k = parameter * numBins + i;
+
+        // Media y varianza de los promedios de los bloques (Welford)
+        long long n = 0;
+        double mean = 0.0, m2 = 0.0;
+        for (const auto& [index, block] : blocks) {
+            if (block.count[k] == 0) {
+                continue;
+            }
+            const double value = block.sum[k] / block.count[k];
+            ++n;
+            const double delta = value - mean;
+            mean += delta / n;
+            m2 += delta * (value - mean);
+        }
+        const double sem = n > 1 ? std::sqrt(m2 / (n - 1) / n) : 0.0;
+
+        file << std::fixed << std::setprecision(3) << minDistance + (i + 0.5) * binWidth << " "
+             << std::setprecision(6) << mean << " " << sem << " " << n << "\n";
+    }
+}
+
+void BlockAverages::saveSeries(const std::string& filename, size_t parameter,
+                               const std::string& name) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
+        return;
+    }
+
+    file << "# Serie temporal de " << name << ": frame y promedio por bin de r\n";
+    file << "# frame" << std::fixed << std::setprecision(3);
+    for (int i = 0; i < numBins; ++i) {
+        file << " " << minDistance + (i + 0.5) * binWidth;
+    }
+    file << "\n" << std::setprecision(6);
+
+    for (const auto& [sequence, row] : series) {
+        file << row.first;
+        for (int i = 0; i < numBins; ++i) {
+            const float value = row.second[parameter * numBins + i];
+            if (std::isnan(value)) {
+                file << " nan";
+            } else {
+                file << " " << value;
+            }
+        }
+        file << "\n";
+    }
+}
+
+void BlockAverages::save(std::ostream& out) const {
+    const uint64_t numBlocks = blocks.size();
+    out.write(reinterpret_cast<const char*>(&numBlocks), sizeof(numBlocks));
+    for (const auto& [index, block] : blocks) {
+        const uint64_t blockIndex = index;
+        out.write(reinterpret_cast<const char*>(&blockIndex), sizeof(blockIndex));
+        out.write(reinterpret_cast<const char*>(block.sum.data()), block.sum.size() * sizeof(double));
+        out.write(reinterpret_cast<const char*>(block.count.data()), block.count.size() * sizeof(long long));
+    }
+}
+
+void BlockAverages::load(std::istream& in) {
+    uint64_t numBlocks = 0;
+    in.read(reinterpret_cast<char*>(&numBlocks), sizeof(numBlocks));
+    for (uint64_t b = 0; in && b < numBlocks; ++b) {
+        uint64_t blockIndex;
+        in.read(reinterpret_cast<char*>(&blockIndex), sizeof(blockIndex));
+        FrameBins block = emptyFrame();
+        in.read(reinterpret_cast<char*>(block.sum.data()), block.sum.size() * sizeof(double));
+        in.read(reinterpret_cast<char*>(block.count.data()), block.count.size() * sizeof(long long));
+        auto [it, inserted] = blocks.try_emplace(blockIndex);
+        if (inserted) {
+            it->second = emptyFrame();
+        }
+        for (size_t k = 0; k < block.sum.size(); ++k) {
+            it->second.sum[k] += block.sum[k];
+            it->second.count[k] += block.count[k];
+        }
+    }
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado");
+    }
+}
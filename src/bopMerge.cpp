@@ -0,0 +1,76 @@
+// bopMerge.cpp
+// Combina los resultados parciales de varias corridas de bop-rdf (por
+// ejemplo, los shards de -shard i/N) y escribe los mismos archivos que una
+// sola corrida sobre todos los frames.
+#include "ProteinWaterAnalyzer.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+void showUsage(const char* programName) {
+    std::cout << "Uso: " << programName << " [opciones] <parcial> [<parcial> ...]" << std::endl;
+    std::cout << "Opciones:" << std::endl;
+    std::cout << "  -o <archivo>   Archivo de salida (por defecto: histograma.dat)" << std::endl;
+    std::cout << "  -combined      Con varios parámetros, escribir un solo archivo con todas las columnas" << std::endl;
+    std::cout << "  -partial <archivo> Escribir la combinación como un nuevo resultado parcial" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Los parciales deben tener los mismos parámetros de orden, bins, -2d y -block," << std::endl;
+    std::cout << "y ningún frame puede aparecer en más de uno." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Ejemplo:" << std::endl;
+    std::cout << "  " << programName << " -o resultado.dat histograma.dat.*.part" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string outputFile = "histograma.dat";
+    std::string partialFile;
+    bool combinedOutput = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputFile = argv[++i];
+        } else if (arg == "-partial" && i + 1 < argc) {
+            partialFile = argv[++i];
+        } else if (arg == "-combined") {
+            combinedOutput = true;
+        } else if (arg == "-h" || arg == "--help") {
+            showUsage(argv[0]);
+            return 0;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        showUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        auto analyzer = ProteinWaterAnalyzer::fromPartial(inputs.front());
+        size_t totalFrames = 0;
+        for (const auto& input : inputs) {
+            size_t frames = analyzer->mergePartial(input);
+            std::cout << "  " << input << ": " << frames << " frames" << std::endl;
+            totalFrames += frames;
+        }
+        std::cout << "Combinados " << inputs.size() << " resultados parciales (" << totalFrames
+                  << " frames)" << std::endl;
+
+        if (!partialFile.empty()) {
+            std::cout << "Guardando resultado parcial en: " << partialFile << std::endl;
+            analyzer->writePartial(partialFile);
+        } else {
+            std::cout << "Guardando histograma..." << std::endl;
+            analyzer->saveHistogram(outputFile, combinedOutput);
+        }
+        analyzer->printStatistics();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,256 @@
+// src/cellList.cpp
+#include "CellList.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+template <typename Real>
+CellList<Real>::CellList(const PositionsView& atoms, const PeriodicBox& box_, double cellSize)
+    : box(box_), kernel(distanceKernel<Real>(box_.kind)) {
+    // Las celdas se arman sobre las coordenadas fraccionarias; su ancho es
+    // la distancia entre planos de la red, que en la caja triclínica es
+    // menor que la longitud del eje
+    double widthX = box.Lx, widthY = box.Ly, widthZ = box.Lz;
+    if (box.kind == BoxKind::Triclinic) {
+        // Alturas de la celda: volumen / área de la cara opuesta
+        const double volume = box.Lx * box.Ly * box.Lz;
+        widthX = volume / std::sqrt(std::pow(box.Ly * box.Lz, 2) + std::pow(box.xy * box.Lz, 2) +
+                                    std::pow(box.xy * box.yz - box.Ly * box.xz, 2));
+        widthY = volume / std::sqrt(std::pow(box.Lx * box.Lz, 2) + std::pow(box.Lx * box.yz, 2));
+    }
+    nx = std::max(1, static_cast<int>(std::floor(widthX / cellSize)));
+    ny = std::max(1, static_cast<int>(std::floor(widthY / cellSize)));
+    nz = std::max(1, static_cast<int>(std::floor(widthZ / cellSize)));
+    cellX = box.Lx / nx;
+    cellY = box.Ly / ny;
+    cellZ = box.Lz / nz;
+    spacingX = widthX / nx;
+    spacingY = widthY / ny;
+    spacingZ = widthZ / nz;
+    minCellWidth = std::min({spacingX, spacingY, spacingZ});
+    // En float el error de redondeo de las distancias es mucho mayor
+    tolerance = (std::is_same_v<Real, float> ? 1e-6 : 1e-9) * (box.Lx + box.Ly + box.Lz);
+
+    // Ordenar los átomos por celda (counting sort)
+    const size_t numCells = static_cast<size_t>(nx) * ny * nz;
+    std::vector<int> atomCell(atoms.size());
+    cellStart.assign(numCells + 1, 0);
+
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        int c = cellOf(atoms.x[i], atoms.y[i], atoms.z[i]);
+        atomCell[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (size_t c = 0; c < numCells; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    atomX.resize(atoms.size());
+    atomY.resize(atoms.size());
+    atomZ.resize(atoms.size());
+    atomIndex.resize(atoms.size());
+    std::vector<int> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < atoms.size(); ++i) {
+        int pos = next[atomCell[i]]++;
+        atomX[pos] = atoms.x[i];
+        atomY[pos] = atoms.y[i];
+        atomZ[pos] = atoms.z[i];
+        atomIndex[pos] = static_cast<int>(i);
+    }
+}
+
+template <typename Real>
+int CellList<Real>::cellIndex(double coord, double cellWidth, int n) const {
+    int c = static_cast<int>(std::floor(coord / cellWidth)) % n;
+    return c < 0 ? c + n : c;
+}
+
+template <typename Real>
+int CellList<Real>::cellOf(double x, double y, double z) const {
+    if (box.kind == BoxKind::Triclinic) {
+        // Coordenadas fraccionarias, escaladas por la longitud de cada eje
+        const double c = z * box.invLz;
+        const double b = (y - c * box.yz) * box.invLy;
+        x -= b * box.xy + c * box.xz;
+        y -= c * box.yz;
+    }
+    return (cellIndex(z, cellZ, nz) * ny + cellIndex(y, cellY, ny)) * nx + cellIndex(x, cellX, nx);
+}
+
+template <typename Real>
+void CellList<Real>::scanRow(int cx, int dxFrom, int dxTo, int cy, int cz,
+                             const Real* wx, const Real* wy, const Real* wz, size_t n,
+                             Real* minDist2) const {
+    if (cy < 0) cy += ny; else if (cy >= ny) cy -= ny;
+    if (cz < 0) cz += nz; else if (cz >= nz) cz -= nz;
+    const int row = (cz * ny + cy) * nx;
+
+    // Con periodicidad la fila puede quedar partida en dos rangos contiguos
+    auto scan = [&](int from, int to) {
+        const int first = cellStart[row + from];
+        const int last = cellStart[row + to + 1];
+        if (last > first) {
+            kernel(atomX.data() + first, atomY.data() + first, atomZ.data() + first,
+                   last - first, wx, wy, wz, n, box, minDist2);
+        }
+    };
+
+    int from = cx + dxFrom;
+    int to = cx + dxTo;
+    if (to < 0) {
+        scan(from + nx, to + nx);
+    } else if (from >= nx) {
+        scan(from - nx, to - nx);
+    } else if (from < 0) {
+        scan(from + nx, nx - 1);
+        scan(0, to);
+    } else if (to >= nx) {
+        scan(from, nx - 1);
+        scan(0, to - nx);
+    } else {
+        scan(from, to);
+    }
+}
+
+template <typename Real>
+void CellList<Real>::searchGroup(int cell, const Real* wx, const Real* wy, const Real* wz,
+                                 size_t n, double maxDistance, Real* minDist2) const {
+    const int cx = cell % nx;
+    const int cy = (cell / nx) % ny;
+    const int cz = cell / (nx * ny);
+
+    // Desplazamientos de celda distintos por eje (con periodicidad cada
+    // celda aparece una sola vez, con el desplazamiento de menor módulo)
+    const int loX = -(nx / 2), hiX = nx - 1 - nx / 2;
+    const int loY = -(ny / 2), hiY = ny - 1 - ny / 2;
+    const int loZ = -(nz / 2), hiZ = nz - 1 - nz / 2;
+
+    // Rango de la capa anterior (vacío al comienzo)
+    int px0 = 1, px1 = 0, py0 = 1, py1 = 0, pz0 = 1, pz1 = 0;
+
+    for (int s = 0; ; ++s) {
+        const int x0 = std::max(-s, loX), x1 = std::min(s, hiX);
+        const int y0 = std::max(-s, loY), y1 = std::min(s, hiY);
+        const int z0 = std::max(-s, loZ), z1 = std::min(s, hiZ);
+
+        // Toda la grilla ya fue recorrida
+        if (x0 == px0 && x1 == px1 && y0 == py0 && y1 == py1 && z0 == pz0 && z1 == pz1) {
+            return;
+        }
+
+        // Recorrer solo las celdas nuevas de la capa s
+        for (int dz = z0; dz <= z1; ++dz) {
+            const bool innerZ = dz >= pz0 && dz <= pz1;
+            for (int dy = y0; dy <= y1; ++dy) {
+                const bool innerY = dy >= py0 && dy <= py1;
+                if (innerZ && innerY) {
+                    if (x0 < px0) scanRow(cx, x0, x0, cy + dy, cz + dz, wx, wy, wz, n, minDist2);
+                    if (x1 > px1) scanRow(cx, x1, x1, cy + dy, cz + dz, wx, wy, wz, n, minDist2);
+                } else {
+                    scanRow(cx, x0, x1, cy + dy, cz + dz, wx, wy, wz, n, minDist2);
+                }
+            }
+        }
+
+        // Los átomos no recorridos están al menos a s anchos de celda
+        const double bound = s * minCellWidth - tolerance;
+        if (bound > maxDistance) {
+            return;
+        }
+        if (bound > 0) {
+            const double worst = *std::max_element(minDist2, minDist2 + n);
+            if (worst <= bound * bound) {
+                return;
+            }
+        }
+
+        px0 = x0; px1 = x1;
+        py0 = y0; py1 = y1;
+        pz0 = z0; pz1 = z1;
+    }
+}
+
+template <typename Real>
+void CellList<Real>::findMinDistances(const double* wx, const double* wy, const double* wz,
+                                      size_t numWaters, double maxDistance, double* minDist) const {
+    if (atomX.empty()) {
+        std::fill(minDist, minDist + numWaters, std::numeric_limits<double>::max());
+        return;
+    }
+
+    // Agrupar las aguas por celda: todas comparten las mismas capas
+    std::vector<std::pair<int, size_t>> order(numWaters);
+    for (size_t i = 0; i < numWaters; ++i) {
+        order[i] = {cellOf(wx[i], wy[i], wz[i]), i};
+    }
+    std::sort(order.begin(), order.end());
+
+    // Cada grupo se pasa a la precisión de la grilla
+    Real gx[kernelWaterBlock], gy[kernelWaterBlock], gz[kernelWaterBlock];
+    Real best2[kernelWaterBlock];
+
+    size_t i = 0;
+    while (i < numWaters) {
+        const int cell = order[i].first;
+        size_t n = 0;
+        while (i + n < numWaters && n < kernelWaterBlock && order[i + n].first == cell) {
+            size_t w = order[i + n].second;
+            gx[n] = static_cast<Real>(wx[w]);
+            gy[n] = static_cast<Real>(wy[w]);
+            gz[n] = static_cast<Real>(wz[w]);
+            best2[n] = std::numeric_limits<Real>::max();
+            ++n;
+        }
+
+        searchGroup(cell, gx, gy, gz, n, maxDistance, best2);
+
+        // Una sola raíz cuadrada por agua
+        for (size_t k = 0; k < n; ++k) {
+            minDist[order[i + k].second] = std::sqrt(static_cast<double>(best2[k]));
+        }
+        i += n;
+    }
+}
+
+template <typename Real>
+void CellList<Real>::findNeighbors(double x, double y, double z, double radius,
+                                   std::vector<int>& neighbors) const {
+    const int cell = cellOf(x, y, z);
+    const int cx = cell % nx;
+    const int cy = (cell / nx) % ny;
+    const int cz = cell / (nx * ny);
+
+    // Celdas que pueden tener átomos a menos de radius, cada una una sola
+    // vez aunque el rango cubra la caja entera
+    const int kx = static_cast<int>(std::ceil(radius / spacingX));
+    const int ky = static_cast<int>(std::ceil(radius / spacingY));
+    const int kz = static_cast<int>(std::ceil(radius / spacingZ));
+    const int x0 = std::max(-kx, -(nx / 2)), x1 = std::min(kx, nx - 1 - nx / 2);
+    const int y0 = std::max(-ky, -(ny / 2)), y1 = std::min(ky, ny - 1 - ny / 2);
+    const int z0 = std::max(-kz, -(nz / 2)), z1 = std::min(kz, nz - 1 - nz / 2);
+
+    const double radius2 = radius * radius;
+    for (int dz = z0; dz <= z1; ++dz) {
+        const int c3 = ((cz + dz) % nz + nz) % nz;
+        for (int dy = y0; dy <= y1; ++dy) {
+            const int c2 = ((cy + dy) % ny + ny) % ny;
+            for (int dx = x0; dx <= x1; ++dx) {
+                const int c = (c3 * ny + c2) * nx + ((cx + dx) % nx + nx) % nx;
+                for (int a = cellStart[c]; a < cellStart[c + 1]; ++a) {
+                    double ddx = x - atomX[a];
+                    double ddy = y - atomY[a];
+                    double ddz = z - atomZ[a];
+                    box.minimumImage(ddx, ddy, ddz);
+                    if (ddx*ddx + ddy*ddy + ddz*ddz <= radius2) {
+                        neighbors.push_back(atomIndex[a]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template class CellList<double>;
+template class CellList<float>;
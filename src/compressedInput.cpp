@@ -0,0 +1,293 @@
+// src/compressedInput.cpp
+#include "CompressedInput.h"
+#include "BoundedQueue.h"
+#include <algorithm>
+#include <climits>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef BOP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef BOP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+// Bloques que se leen del disco y que el hilo de lectura anticipada
+// entrega ya descomprimidos
+constexpr size_t inputChunk = 1 << 20;
+constexpr size_t readAheadChunks = 8;
+
+class FileInput : public InputStream {
+private:
+    std::string filename;
+    int fd;
+
+public:
+    explicit FileInput(const std::string& filename_) : filename(filename_) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+        }
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    ~FileInput() override { ::close(fd); }
+
+    size_t read(char* buffer, size_t size) override {
+        ssize_t n = ::read(fd, buffer, size);
+        if (n < 0) {
+            throw std::runtime_error("Error leyendo el archivo: " + filename);
+        }
+        return static_cast<size_t>(n);
+    }
+};
+
+#ifdef BOP_HAVE_ZLIB
+// gzip (admite varios miembros concatenados, como los de pigz o cat)
+class GzipInput : public InputStream {
+private:
+    std::unique_ptr<InputStream> source;
+    std::string filename;
+    z_stream stream{};
+    std::vector<char> input;
+    bool sourceDone = false;
+    bool inMember = false;     // Hay un miembro empezado sin terminar
+
+public:
+    GzipInput(std::unique_ptr<InputStream> source_, const std::string& filename_)
+        : source(std::move(source_)), filename(filename_), input(inputChunk) {
+        // 15 + 32: ventana máxima y detección automática de la cabecera gzip/zlib
+        if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+            throw std::runtime_error("No se pudo inicializar zlib para: " + filename);
+        }
+    }
+
+    ~GzipInput() override { inflateEnd(&stream); }
+
+    size_t read(char* buffer, size_t size) override {
+        const uInt capacity = static_cast<uInt>(std::min<size_t>(size, UINT_MAX));
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = capacity;
+        while (stream.avail_out == capacity) {
+            if (stream.avail_in == 0 && !sourceDone) {
+                size_t n = source->read(input.data(), input.size());
+                if (n == 0) {
+                    sourceDone = true;
+                } else {
+                    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                    stream.avail_in = static_cast<uInt>(n);
+                }
+            }
+            if (stream.avail_in == 0 && sourceDone) {
+                if (inMember) {
+                    throw std::runtime_error("Archivo gzip truncado: " + filename);
+                }
+                break;
+            }
+            inMember = true;
+            int result = inflate(&stream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END) {
+                inMember = false;
+                inflateReset(&stream);
+            } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                throw std::runtime_error("Error descomprimiendo " + filename + ": " +
+                                         (stream.msg ? stream.msg : "datos gzip inválidos"));
+            }
+        }
+        return capacity - stream.avail_out;
+    }
+};
+#endif
+
+#ifdef BOP_HAVE_ZSTD
+// zstd (admite varios frames concatenados)
+class ZstdInput : public InputStream {
+private:
+    std::unique_ptr<InputStream> source;
+    std::string filename;
+    ZSTD_DStream* stream;
+    std::vector<char> input;
+    ZSTD_inBuffer in;
+    bool sourceDone = false;
+    size_t pending = 0;        // Distinto de 0: frame empezado sin terminar
+
+public:
+    ZstdInput(std::unique_ptr<InputStream> source_, const std::string& filename_)
+        : source(std::move(source_)), filename(filename_), stream(ZSTD_createDStream()),
+          input(ZSTD_DStreamInSize()) {
+        if (!stream || ZSTD_isError(ZSTD_initDStream(stream))) {
+            throw std::runtime_error("No se pudo inicializar zstd para: " + filename);
+        }
+        in = {input.data(), 0, 0};
+    }
+
+    ~ZstdInput() override { ZSTD_freeDStream(stream); }
+
+    size_t read(char* buffer, size_t size) override {
+        ZSTD_outBuffer out = {buffer, size, 0};
+        while (out.pos == 0) {
+            if (in.pos == in.size && !sourceDone) {
+                size_t n = source->read(input.data(), input.size());
+                if (n == 0) {
+                    sourceDone = true;
+                } else {
+                    in = {input.data(), n, 0};
+                }
+            }
+            // Sin entrada nueva igual se llama, para vaciar la salida retenida
+            size_t result = ZSTD_decompressStream(stream, &out, &in);
+            if (ZSTD_isError(result)) {
+                throw std::runtime_error("Error descomprimiendo " + filename + ": " +
+                                         ZSTD_getErrorName(result));
+            }
+            pending = result;
+            if (sourceDone && in.pos == in.size && out.pos == 0) {
+                if (pending != 0) {
+                    throw std::runtime_error("Archivo zstd truncado: " + filename);
+                }
+                break;
+            }
+        }
+        return out.pos;
+    }
+};
+#endif
+
+// Lee source en un hilo propio, de a bloques, con hasta readAheadChunks
+// bloques listos por adelantado. Un error del hilo se relanza en read().
+class ReadAheadInput : public InputStream {
+private:
+    std::unique_ptr<InputStream> source;
+    BoundedQueue<std::vector<char>> chunks;
+    std::exception_ptr error;             // Escrito antes de cerrar la cola
+    std::vector<char> current;
+    size_t position = 0;
+    std::thread thread;
+
+    void run() {
+        try {
+            while (true) {
+                std::vector<char> chunk(inputChunk);
+                size_t filled = 0;
+                while (filled < chunk.size()) {
+                    size_t n = source->read(chunk.data() + filled, chunk.size() - filled);
+                    if (n == 0) {
+                        break;
+                    }
+                    filled += n;
+                }
+                if (filled == 0) {
+                    break;
+                }
+                chunk.resize(filled);
+                if (!chunks.push(std::move(chunk))) {
+                    return;   // Cerrada por el destructor
+                }
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        chunks.close();
+    }
+
+public:
+    explicit ReadAheadInput(std::unique_ptr<InputStream> source_)
+        : source(std::move(source_)), chunks(readAheadChunks) {
+        thread = std::thread(&ReadAheadInput::run, this);
+    }
+
+    ~ReadAheadInput() override {
+        chunks.close();
+        thread.join();
+    }
+
+    size_t read(char* buffer, size_t size) override {
+        if (position == current.size()) {
+            if (!chunks.pop(current)) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return 0;
+            }
+            position = 0;
+        }
+        const size_t n = std::min(size, current.size() - position);
+        std::copy(current.data() + position, current.data() + position + n, buffer);
+        position += n;
+        return n;
+    }
+};
+
+std::unique_ptr<InputStream> decompressing(std::unique_ptr<InputStream> file,
+                                           const std::string& filename) {
+    switch (compressionOf(filename)) {
+        case Compression::Gzip:
+#ifdef BOP_HAVE_ZLIB
+            return std::make_unique<GzipInput>(std::move(file), filename);
+#else
+            throw std::runtime_error("bop-rdf se compiló sin soporte para gzip (zlib): " + filename);
+#endif
+        case Compression::Zstd:
+#ifdef BOP_HAVE_ZSTD
+            return std::make_unique<ZstdInput>(std::move(file), filename);
+#else
+            throw std::runtime_error("bop-rdf se compiló sin soporte para zstd (libzstd): " + filename);
+#endif
+        default:
+            return file;
+    }
+}
+
+} // namespace
+
+Compression compressionOf(std::string_view filename) {
+    if (filename.ends_with(".gz")) {
+        return Compression::Gzip;
+    }
+    if (filename.ends_with(".zst")) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+std::string_view withoutCompression(std::string_view filename) {
+    switch (compressionOf(filename)) {
+        case Compression::Gzip: return filename.substr(0, filename.size() - 3);
+        case Compression::Zstd: return filename.substr(0, filename.size() - 4);
+        default: return filename;
+    }
+}
+
+std::unique_ptr<InputStream> openInput(const std::string& filename, bool readAhead) {
+    auto input = decompressing(std::make_unique<FileInput>(filename), filename);
+    if (readAhead && compressionOf(filename) != Compression::None) {
+        input = std::make_unique<ReadAheadInput>(std::move(input));
+    }
+    return input;
+}
+
+uint64_t decompressFile(const std::string& filename, std::vector<char>& out) {
+    auto input = openInput(filename);
+    const uint64_t compressedSize = std::filesystem::file_size(filename);
+    // Los XYZ comprimen a un cuarto o menos; el buffer crece si hace falta
+    size_t used = 0;
+    out.resize(std::max<size_t>(out.capacity(), 4 * compressedSize + inputChunk));
+    while (true) {
+        if (used == out.size()) {
+            out.resize(2 * out.size());
+        }
+        size_t n = input->read(out.data() + used, out.size() - used);
+        if (n == 0) {
+            break;
+        }
+        used += n;
+    }
+    out.resize(used);
+    return compressedSize;
+}
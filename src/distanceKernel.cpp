@@ -0,0 +1,518 @@
+// src/distanceKernel.cpp
+// Variantes del núcleo de distancias. Las versiones vectoriales se compilan
+// con atributos target y se eligen en tiempo de ejecución, de modo que el
+// mismo binario aprovecha AVX2/AVX-512 sin depender de -march=native.
+// Cada variante se instancia por precisión y por tipo de caja; la imagen
+// mínima se resuelve en tiempo de compilación, sin ramas en el bucle.
+#include "DistanceKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOP_X86_KERNELS 1
+#endif
+
+namespace {
+
+// Caja en la precisión del núcleo
+template <typename Real>
+struct BoxOf {
+    Real Lx, Ly, Lz;
+    Real invLx, invLy, invLz;
+    Real xy, xz, yz;
+
+    explicit BoxOf(const PeriodicBox& box)
+        : Lx(static_cast<Real>(box.Lx)), Ly(static_cast<Real>(box.Ly)), Lz(static_cast<Real>(box.Lz)),
+          invLx(static_cast<Real>(box.invLx)), invLy(static_cast<Real>(box.invLy)),
+          invLz(static_cast<Real>(box.invLz)),
+          xy(static_cast<Real>(box.xy)), xz(static_cast<Real>(box.xz)), yz(static_cast<Real>(box.yz)) {}
+};
+
+// Distancia al cuadrado con imagen mínima, con las mismas operaciones que
+// PeriodicBox::minimumImage. nearbyint redondea al par más cercano, igual
+// que las instrucciones de redondeo vectoriales.
+template <BoxKind Kind, typename Real>
+inline Real pairDistance2(Real x, Real y, Real z, Real ax, Real ay, Real az,
+                          const BoxOf<Real>& box) {
+    Real dx = x - ax;
+    Real dy = y - ay;
+    Real dz = z - az;
+
+    if constexpr (Kind == BoxKind::Orthorhombic) {
+        dx -= box.Lx * std::nearbyint(dx * box.invLx);
+        dy -= box.Ly * std::nearbyint(dy * box.invLy);
+        dz -= box.Lz * std::nearbyint(dz * box.invLz);
+    } else if constexpr (Kind == BoxKind::Triclinic) {
+        const Real nz = std::nearbyint(dz * box.invLz);
+        dx -= box.xz * nz;
+        dy -= box.yz * nz;
+        dz -= box.Lz * nz;
+        const Real ny = std::nearbyint(dy * box.invLy);
+        dx -= box.xy * ny;
+        dy -= box.Ly * ny;
+        dx -= box.Lx * std::nearbyint(dx * box.invLx);
+    }
+
+    return dx*dx + dy*dy + dz*dz;
+}
+
+template <BoxKind Kind, typename Real>
+void minDistance2Scalar(const Real* ax, const Real* ay, const Real* az,
+                        size_t numAtoms,
+                        const Real* wx, const Real* wy, const Real* wz,
+                        size_t numWaters,
+                        const PeriodicBox& periodicBox, Real* minDist2) {
+    const BoxOf<Real> box(periodicBox);
+    for (size_t w = 0; w < numWaters; ++w) {
+        Real best = minDist2[w];
+        for (size_t i = 0; i < numAtoms; ++i) {
+            best = std::min(best, pairDistance2<Kind>(wx[w], wy[w], wz[w], ax[i], ay[i], az[i], box));
+        }
+        minDist2[w] = best;
+    }
+}
+
+#ifdef BOP_X86_KERNELS
+
+// Caja replicada en todos los carriles de un registro, una por tipo de
+// registro (los tipos vectoriales no sirven como argumento de plantilla)
+struct VecBox256d {
+    __m256d Lx, Ly, Lz;
+    __m256d invLx, invLy, invLz;
+    __m256d xy, xz, yz;
+};
+
+struct VecBox256 {
+    __m256 Lx, Ly, Lz;
+    __m256 invLx, invLy, invLz;
+    __m256 xy, xz, yz;
+};
+
+struct VecBox512d {
+    __m512d Lx, Ly, Lz;
+    __m512d invLx, invLy, invLz;
+    __m512d xy, xz, yz;
+};
+
+struct VecBox512 {
+    __m512 Lx, Ly, Lz;
+    __m512 invLx, invLy, invLz;
+    __m512 xy, xz, yz;
+};
+
+constexpr int roundMode = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+__attribute__((target("avx2")))
+inline VecBox256d broadcastAvx2(const BoxOf<double>& b) {
+    return {_mm256_set1_pd(b.Lx), _mm256_set1_pd(b.Ly), _mm256_set1_pd(b.Lz),
+            _mm256_set1_pd(b.invLx), _mm256_set1_pd(b.invLy), _mm256_set1_pd(b.invLz),
+            _mm256_set1_pd(b.xy), _mm256_set1_pd(b.xz), _mm256_set1_pd(b.yz)};
+}
+
+__attribute__((target("avx2")))
+inline VecBox256 broadcastAvx2(const BoxOf<float>& b) {
+    return {_mm256_set1_ps(b.Lx), _mm256_set1_ps(b.Ly), _mm256_set1_ps(b.Lz),
+            _mm256_set1_ps(b.invLx), _mm256_set1_ps(b.invLy), _mm256_set1_ps(b.invLz),
+            _mm256_set1_ps(b.xy), _mm256_set1_ps(b.xz), _mm256_set1_ps(b.yz)};
+}
+
+__attribute__((target("avx512f")))
+inline VecBox512d broadcastAvx512(const BoxOf<double>& b) {
+    return {_mm512_set1_pd(b.Lx), _mm512_set1_pd(b.Ly), _mm512_set1_pd(b.Lz),
+            _mm512_set1_pd(b.invLx), _mm512_set1_pd(b.invLy), _mm512_set1_pd(b.invLz),
+            _mm512_set1_pd(b.xy), _mm512_set1_pd(b.xz), _mm512_set1_pd(b.yz)};
+}
+
+__attribute__((target("avx512f")))
+inline VecBox512 broadcastAvx512(const BoxOf<float>& b) {
+    return {_mm512_set1_ps(b.Lx), _mm512_set1_ps(b.Ly), _mm512_set1_ps(b.Lz),
+            _mm512_set1_ps(b.invLx), _mm512_set1_ps(b.invLy), _mm512_set1_ps(b.invLz),
+            _mm512_set1_ps(b.xy), _mm512_set1_ps(b.xz), _mm512_set1_ps(b.yz)};
+}
+
+// Distancia al cuadrado de cada carril, con la misma imagen mínima que
+// pairDistance2. Una sobrecarga por tipo de registro.
+template <BoxKind Kind>
+__attribute__((target("avx2")))
+inline __m256d distance2(__m256d dx, __m256d dy, __m256d dz, const VecBox256d& b) {
+    if constexpr (Kind == BoxKind::Orthorhombic) {
+        dx = _mm256_sub_pd(dx, _mm256_mul_pd(b.Lx, _mm256_round_pd(_mm256_mul_pd(dx, b.invLx), roundMode)));
+        dy = _mm256_sub_pd(dy, _mm256_mul_pd(b.Ly, _mm256_round_pd(_mm256_mul_pd(dy, b.invLy), roundMode)));
+        dz = _mm256_sub_pd(dz, _mm256_mul_pd(b.Lz, _mm256_round_pd(_mm256_mul_pd(dz, b.invLz), roundMode)));
+    } else if constexpr (Kind == BoxKind::Triclinic) {
+        const __m256d nz = _mm256_round_pd(_mm256_mul_pd(dz, b.invLz), roundMode);
+        dx = _mm256_sub_pd(dx, _mm256_mul_pd(b.xz, nz));
+        dy = _mm256_sub_pd(dy, _mm256_mul_pd(b.yz, nz));
+        dz = _mm256_sub_pd(dz, _mm256_mul_pd(b.Lz, nz));
+        const __m256d ny = _mm256_round_pd(_mm256_mul_pd(dy, b.invLy), roundMode);
+        dx = _mm256_sub_pd(dx, _mm256_mul_pd(b.xy, ny));
+        dy = _mm256_sub_pd(dy, _mm256_mul_pd(b.Ly, ny));
+        dx = _mm256_sub_pd(dx, _mm256_mul_pd(b.Lx, _mm256_round_pd(_mm256_mul_pd(dx, b.invLx), roundMode)));
+    }
+    return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                         _mm256_mul_pd(dz, dz));
+}
+
+template <BoxKind Kind>
+__attribute__((target("avx2")))
+inline __m256 distance2(__m256 dx, __m256 dy, __m256 dz, const VecBox256& b) {
+    if constexpr (Kind == BoxKind::Orthorhombic) {
+        dx = _mm256_sub_ps(dx, _mm256_mul_ps(b.Lx, _mm256_round_ps(_mm256_mul_ps(dx, b.invLx), roundMode)));
+        dy = _mm256_sub_ps(dy, _mm256_mul_ps(b.Ly, _mm256_round_ps(_mm256_mul_ps(dy, b.invLy), roundMode)));
+        dz = _mm256_sub_ps(dz, _mm256_mul_ps(b.Lz, _mm256_round_ps(_mm256_mul_ps(dz, b.invLz), roundMode)));
+    } else if constexpr (Kind == BoxKind::Triclinic) {
+        const __m256 nz = _mm256_round_ps(_mm256_mul_ps(dz, b.invLz), roundMode);
+        dx = _mm256_sub_ps(dx, _mm256_mul_ps(b.xz, nz));
+        dy = _mm256_sub_ps(dy, _mm256_mul_ps(b.yz, nz));
+        dz = _mm256_sub_ps(dz, _mm256_mul_ps(b.Lz, nz));
+        const __m256 ny = _mm256_round_ps(_mm256_mul_ps(dy, b.invLy), roundMode);
+        dx = _mm256_sub_ps(dx, _mm256_mul_ps(b.xy, ny));
+        dy = _mm256_sub_ps(dy, _mm256_mul_ps(b.Ly, ny));
+        dx = _mm256_sub_ps(dx, _mm256_mul_ps(b.Lx, _mm256_round_ps(_mm256_mul_ps(dx, b.invLx), roundMode)));
+    }
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                         _mm256_mul_ps(dz, dz));
+}
+
+template <BoxKind Kind>
+__attribute__((target("avx512f")))
+inline __m512d distance2(__m512d dx, __m512d dy, __m512d dz, const VecBox512d& b) {
+    if constexpr (Kind == BoxKind::Orthorhombic) {
+        dx = _mm512_sub_pd(dx, _mm512_mul_pd(b.Lx, _mm512_roundscale_pd(_mm512_mul_pd(dx, b.invLx), roundMode)));
+        dy = _mm512_sub_pd(dy, _mm512_mul_pd(b.Ly, _mm512_roundscale_pd(_mm512_mul_pd(dy, b.invLy), roundMode)));
+        dz = _mm512_sub_pd(dz, _mm512_mul_pd(b.Lz, _mm512_roundscale_pd(_mm512_mul_pd(dz, b.invLz), roundMode)));
+    } else if constexpr (Kind == BoxKind::Triclinic) {
+        const __m512d nz = _mm512_roundscale_pd(_mm512_mul_pd(dz, b.invLz), roundMode);
+        dx = _mm512_sub_pd(dx, _mm512_mul_pd(b.xz, nz));
+        dy = _mm512_sub_pd(dy, _mm512_mul_pd(b.yz, nz));
+        dz = _mm512_sub_pd(dz, _mm512_mul_pd(b.Lz, nz));
+        const __m512d ny = _mm512_roundscale_pd(_mm512_mul_pd(dy, b.invLy), roundMode);
+        dx = _mm512_sub_pd(dx, _mm512_mul_pd(b.xy, ny));
+        dy = _mm512_sub_pd(dy, _mm512_mul_pd(b.Ly, ny));
+        dx = _mm512_sub_pd(dx, _mm512_mul_pd(b.Lx, _mm512_roundscale_pd(_mm512_mul_pd(dx, b.invLx), roundMode)));
+    }
+    return _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+                         _mm512_mul_pd(dz, dz));
+}
+
+template <BoxKind Kind>
+__attribute__((target("avx512f")))
+inline __m512 distance2(__m512 dx, __m512 dy, __m512 dz, const VecBox512& b) {
+    if constexpr (Kind == BoxKind::Orthorhombic) {
+        dx = _mm512_sub_ps(dx, _mm512_mul_ps(b.Lx, _mm512_roundscale_ps(_mm512_mul_ps(dx, b.invLx), roundMode)));
+        dy = _mm512_sub_ps(dy, _mm512_mul_ps(b.Ly, _mm512_roundscale_ps(_mm512_mul_ps(dy, b.invLy), roundMode)));
+        dz = _mm512_sub_ps(dz, _mm512_mul_ps(b.Lz, _mm512_roundscale_ps(_mm512_mul_ps(dz, b.invLz), roundMode)));
+    } else if constexpr (Kind == BoxKind::Triclinic) {
+        const __m512 nz = _mm512_roundscale_ps(_mm512_mul_ps(dz, b.invLz), roundMode);
+        dx = _mm512_sub_ps(dx, _mm512_mul_ps(b.xz, nz));
+        dy = _mm512_sub_ps(dy, _mm512_mul_ps(b.yz, nz));
+        dz = _mm512_sub_ps(dz, _mm512_mul_ps(b.Lz, nz));
+        const __m512 ny = _mm512_roundscale_ps(_mm512_mul_ps(dy, b.invLy), roundMode);
+        dx = _mm512_sub_ps(dx, _mm512_mul_ps(b.xy, ny));
+        dy = _mm512_sub_ps(dy, _mm512_mul_ps(b.Ly, ny));
+        dx = _mm512_sub_ps(dx, _mm512_mul_ps(b.Lx, _mm512_roundscale_ps(_mm512_mul_ps(dx, b.invLx), roundMode)));
+    }
+    return _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)),
+                         _mm512_mul_ps(dz, dz));
+}
+
+// NW aguas contra bloques de 4 átomos: cada bloque se carga una sola vez
+// y se reutiliza en registros para todas las aguas del grupo
+template <BoxKind Kind, size_t NW>
+__attribute__((target("avx2")))
+void waterBlockAvx2(const double* ax, const double* ay, const double* az, size_t numAtoms,
+                    const double* wx, const double* wy, const double* wz,
+                    const PeriodicBox& box, double* minDist2) {
+    const BoxOf<double> scalarBox(box);
+    const VecBox256d vecBox = broadcastAvx2(scalarBox);
+
+    __m256d px[NW], py[NW], pz[NW], best[NW];
+    for (size_t k = 0; k < NW; ++k) {
+        px[k] = _mm256_set1_pd(wx[k]);
+        py[k] = _mm256_set1_pd(wy[k]);
+        pz[k] = _mm256_set1_pd(wz[k]);
+        best[k] = _mm256_set1_pd(minDist2[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= numAtoms; i += 4) {
+        const __m256d x = _mm256_loadu_pd(ax + i);
+        const __m256d y = _mm256_loadu_pd(ay + i);
+        const __m256d z = _mm256_loadu_pd(az + i);
+        for (size_t k = 0; k < NW; ++k) {
+            const __m256d d2 = distance2<Kind>(_mm256_sub_pd(px[k], x), _mm256_sub_pd(py[k], y),
+                                               _mm256_sub_pd(pz[k], z), vecBox);
+            best[k] = _mm256_min_pd(best[k], d2);
+        }
+    }
+
+    for (size_t k = 0; k < NW; ++k) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, best[k]);
+        double m = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        for (size_t j = i; j < numAtoms; ++j) {
+            m = std::min(m, pairDistance2<Kind>(wx[k], wy[k], wz[k], ax[j], ay[j], az[j], scalarBox));
+        }
+        minDist2[k] = m;
+    }
+}
+
+// Igual que la versión AVX2 con bloques de 8 átomos; el resto se procesa
+// con cargas enmascaradas en lugar de un bucle escalar
+template <BoxKind Kind, size_t NW>
+__attribute__((target("avx512f")))
+void waterBlockAvx512(const double* ax, const double* ay, const double* az, size_t numAtoms,
+                      const double* wx, const double* wy, const double* wz,
+                      const PeriodicBox& box, double* minDist2) {
+    const VecBox512d vecBox = broadcastAvx512(BoxOf<double>(box));
+
+    __m512d px[NW], py[NW], pz[NW], best[NW];
+    for (size_t k = 0; k < NW; ++k) {
+        px[k] = _mm512_set1_pd(wx[k]);
+        py[k] = _mm512_set1_pd(wy[k]);
+        pz[k] = _mm512_set1_pd(wz[k]);
+        best[k] = _mm512_set1_pd(minDist2[k]);
+    }
+
+    for (size_t i = 0; i < numAtoms; i += 8) {
+        const size_t remaining = numAtoms - i;
+        const __mmask8 mask = remaining >= 8 ? __mmask8(0xFF) : __mmask8((1u << remaining) - 1);
+        const __m512d x = _mm512_maskz_loadu_pd(mask, ax + i);
+        const __m512d y = _mm512_maskz_loadu_pd(mask, ay + i);
+        const __m512d z = _mm512_maskz_loadu_pd(mask, az + i);
+        for (size_t k = 0; k < NW; ++k) {
+            const __m512d d2 = distance2<Kind>(_mm512_sub_pd(px[k], x), _mm512_sub_pd(py[k], y),
+                                               _mm512_sub_pd(pz[k], z), vecBox);
+            best[k] = _mm512_mask_min_pd(best[k], mask, best[k], d2);
+        }
+    }
+
+    for (size_t k = 0; k < NW; ++k) {
+        minDist2[k] = _mm512_reduce_min_pd(best[k]);
+    }
+}
+
+// Versiones en float: 8 (AVX2) o 16 (AVX-512) átomos por bloque, con la
+// misma estructura que las de double
+template <BoxKind Kind, size_t NW>
+__attribute__((target("avx2")))
+void waterBlockAvx2(const float* ax, const float* ay, const float* az, size_t numAtoms,
+                    const float* wx, const float* wy, const float* wz,
+                    const PeriodicBox& box, float* minDist2) {
+    const BoxOf<float> scalarBox(box);
+    const VecBox256 vecBox = broadcastAvx2(scalarBox);
+
+    __m256 px[NW], py[NW], pz[NW], best[NW];
+    for (size_t k = 0; k < NW; ++k) {
+        px[k] = _mm256_set1_ps(wx[k]);
+        py[k] = _mm256_set1_ps(wy[k]);
+        pz[k] = _mm256_set1_ps(wz[k]);
+        best[k] = _mm256_set1_ps(minDist2[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 8 <= numAtoms; i += 8) {
+        const __m256 x = _mm256_loadu_ps(ax + i);
+        const __m256 y = _mm256_loadu_ps(ay + i);
+        const __m256 z = _mm256_loadu_ps(az + i);
+        for (size_t k = 0; k < NW; ++k) {
+            const __m256 d2 = distance2<Kind>(_mm256_sub_ps(px[k], x), _mm256_sub_ps(py[k], y),
+                                              _mm256_sub_ps(pz[k], z), vecBox);
+            best[k] = _mm256_min_ps(best[k], d2);
+        }
+    }
+
+    for (size_t k = 0; k < NW; ++k) {
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, best[k]);
+        float m = *std::min_element(lanes, lanes + 8);
+        for (size_t j = i; j < numAtoms; ++j) {
+            m = std::min(m, pairDistance2<Kind>(wx[k], wy[k], wz[k], ax[j], ay[j], az[j], scalarBox));
+        }
+        minDist2[k] = m;
+    }
+}
+
+template <BoxKind Kind, size_t NW>
+__attribute__((target("avx512f")))
+void waterBlockAvx512(const float* ax, const float* ay, const float* az, size_t numAtoms,
+                      const float* wx, const float* wy, const float* wz,
+                      const PeriodicBox& box, float* minDist2) {
+    const VecBox512 vecBox = broadcastAvx512(BoxOf<float>(box));
+
+    __m512 px[NW], py[NW], pz[NW], best[NW];
+    for (size_t k = 0; k < NW; ++k) {
+        px[k] = _mm512_set1_ps(wx[k]);
+        py[k] = _mm512_set1_ps(wy[k]);
+        pz[k] = _mm512_set1_ps(wz[k]);
+        best[k] = _mm512_set1_ps(minDist2[k]);
+    }
+
+    for (size_t i = 0; i < numAtoms; i += 16) {
+        const size_t remaining = numAtoms - i;
+        const __mmask16 mask = remaining >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << remaining) - 1);
+        const __m512 x = _mm512_maskz_loadu_ps(mask, ax + i);
+        const __m512 y = _mm512_maskz_loadu_ps(mask, ay + i);
+        const __m512 z = _mm512_maskz_loadu_ps(mask, az + i);
+        for (size_t k = 0; k < NW; ++k) {
+            const __m512 d2 = distance2<Kind>(_mm512_sub_ps(px[k], x), _mm512_sub_ps(py[k], y),
+                                              _mm512_sub_ps(pz[k], z), vecBox);
+            best[k] = _mm512_mask_min_ps(best[k], mask, best[k], d2);
+        }
+    }
+
+    for (size_t k = 0; k < NW; ++k) {
+        minDist2[k] = _mm512_reduce_min_ps(best[k]);
+    }
+}
+
+// Recorre las aguas en grupos de kernelWaterBlock; el resto va en un
+// grupo más chico
+template <BoxKind Kind, typename Real>
+__attribute__((target("avx2")))
+void minDistance2Avx2(const Real* ax, const Real* ay, const Real* az,
+                      size_t numAtoms,
+                      const Real* wx, const Real* wy, const Real* wz,
+                      size_t numWaters,
+                      const PeriodicBox& box, Real* minDist2) {
+    size_t w = 0;
+    for (; w + 4 <= numWaters; w += 4) {
+        waterBlockAvx2<Kind, 4>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w);
+    }
+    switch (numWaters - w) {
+        case 3: waterBlockAvx2<Kind, 3>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        case 2: waterBlockAvx2<Kind, 2>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        case 1: waterBlockAvx2<Kind, 1>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        default: break;
+    }
+}
+
+template <BoxKind Kind, typename Real>
+__attribute__((target("avx512f")))
+void minDistance2Avx512(const Real* ax, const Real* ay, const Real* az,
+                        size_t numAtoms,
+                        const Real* wx, const Real* wy, const Real* wz,
+                        size_t numWaters,
+                        const PeriodicBox& box, Real* minDist2) {
+    size_t w = 0;
+    for (; w + 4 <= numWaters; w += 4) {
+        waterBlockAvx512<Kind, 4>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w);
+    }
+    switch (numWaters - w) {
+        case 3: waterBlockAvx512<Kind, 3>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        case 2: waterBlockAvx512<Kind, 2>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        case 1: waterBlockAvx512<Kind, 1>(ax, ay, az, numAtoms, wx + w, wy + w, wz + w, box, minDist2 + w); break;
+        default: break;
+    }
+}
+
+#endif // BOP_X86_KERNELS
+
+// Instancias de una variante para cada tipo de caja (en el orden de BoxKind)
+template <typename Real>
+struct KernelSet {
+    MinDistance2Kernel<Real> byKind[3];
+
+    MinDistance2Kernel<Real> operator[](BoxKind kind) const {
+        return byKind[static_cast<size_t>(kind)];
+    }
+};
+
+template <typename Real, template <BoxKind, typename> class Variant>
+KernelSet<Real> kernelSet() {
+    return {{Variant<BoxKind::None, Real>::function,
+             Variant<BoxKind::Orthorhombic, Real>::function,
+             Variant<BoxKind::Triclinic, Real>::function}};
+}
+
+template <BoxKind Kind, typename Real>
+struct ScalarVariant {
+    static constexpr MinDistance2Kernel<Real> function = minDistance2Scalar<Kind, Real>;
+};
+
+#ifdef BOP_X86_KERNELS
+template <BoxKind Kind, typename Real>
+struct Avx2Variant {
+    static constexpr MinDistance2Kernel<Real> function = minDistance2Avx2<Kind, Real>;
+};
+
+template <BoxKind Kind, typename Real>
+struct Avx512Variant {
+    static constexpr MinDistance2Kernel<Real> function = minDistance2Avx512<Kind, Real>;
+};
+#endif
+
+// Cada variante tiene una instancia por precisión y tipo de caja
+struct KernelChoice {
+    KernelSet<double> kernel64;
+    KernelSet<float> kernel32;
+    const char* name;
+};
+
+template <template <BoxKind, typename> class Variant>
+KernelChoice choiceOf(const char* name) {
+    return {kernelSet<double, Variant>(), kernelSet<float, Variant>(), name};
+}
+
+bool cpuSupports(const std::string& name) {
+#ifdef BOP_X86_KERNELS
+    if (name == "avx2") return __builtin_cpu_supports("avx2");
+    if (name == "avx512") return __builtin_cpu_supports("avx512f");
+#endif
+    return name == "scalar";
+}
+
+KernelChoice makeChoice(const std::string& name) {
+#ifdef BOP_X86_KERNELS
+    if (name == "avx512") return choiceOf<Avx512Variant>("avx512");
+    if (name == "avx2") return choiceOf<Avx2Variant>("avx2");
+#endif
+    return choiceOf<ScalarVariant>("scalar");
+}
+
+KernelChoice bestChoice() {
+    for (const char* name : {"avx512", "avx2"}) {
+        if (cpuSupports(name)) return makeChoice(name);
+    }
+    return makeChoice("scalar");
+}
+
+KernelChoice& currentChoice() {
+    static KernelChoice choice = bestChoice();
+    return choice;
+}
+
+} // namespace
+
+template <typename Real>
+MinDistance2Kernel<Real> distanceKernel(BoxKind kind) {
+    if constexpr (std::is_same_v<Real, float>) {
+        return currentChoice().kernel32[kind];
+    } else {
+        return currentChoice().kernel64[kind];
+    }
+}
+
+template MinDistance2Kernel<double> distanceKernel<double>(BoxKind kind);
+template MinDistance2Kernel<float> distanceKernel<float>(BoxKind kind);
+
+const char* distanceKernelName() {
+    return currentChoice().name;
+}
+
+void selectDistanceKernel(const std::string& name) {
+    if (name == "auto") {
+        currentChoice() = bestChoice();
+        return;
+    }
+    if (name != "scalar" && name != "avx2" && name != "avx512") {
+        throw std::runtime_error("Núcleo de distancias desconocido: " + name);
+    }
+    if (!cpuSupports(name)) {
+        throw std::runtime_error("La CPU no soporta el núcleo de distancias: " + name);
+    }
+    currentChoice() = makeChoice(name);
+}
@@ -0,0 +1,327 @@
+// src/frameCache.cpp
+#include "FrameCache.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+constexpr char cacheMagic[8] = {'B', 'O', 'P', 'C', 'A', 'C', 'H', 'E'};
+constexpr size_t elementNameSize = 8;
+
+inline uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+} // namespace
+
+std::string FrameCache::defaultPath(const std::string& directory) {
+    return (std::filesystem::path(directory) / "frames.bopcache").string();
+}
+
+bool FrameCache::isUpToDate(const std::string& cacheFile, const std::string& directory,
+                            const std::vector<std::string>& sources,
+                            std::optional<std::filesystem::file_time_type> listedTime) {
+    std::error_code ec;
+    auto cacheTime = std::filesystem::last_write_time(cacheFile, ec);
+    if (ec) {
+        return false;
+    }
+    auto directoryTime = std::filesystem::last_write_time(directory, ec);
+    if (ec || (directoryTime > cacheTime && directoryTime != listedTime)) {
+        return false;
+    }
+    for (const auto& source : sources) {
+        auto sourceTime = std::filesystem::last_write_time(source, ec);
+        if (ec || sourceTime > cacheTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FrameCache::FrameCache(const std::string& filename) : filename(filename), file(filename) {
+    if (file.size() < sizeof(FrameCacheHeader)) {
+        throw std::runtime_error("Caché inválido (archivo truncado): " + filename);
+    }
+    header = reinterpret_cast<const FrameCacheHeader*>(file.begin());
+    if (std::memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) != 0) {
+        throw std::runtime_error("Caché inválido (firma incorrecta): " + filename);
+    }
+    if (header->version != version && header->version != 1) {
+        throw std::runtime_error("Versión de caché no soportada en " + filename +
+                                 ": " + std::to_string(header->version));
+    }
+    if (header->realSize != sizeof(float) && header->realSize != sizeof(double)) {
+        throw std::runtime_error("Caché inválido (precisión desconocida): " + filename);
+    }
+    entrySize = header->version == 1 ? offsetof(FrameCacheEntry, xy) : sizeof(FrameCacheEntry);
+    if (header->elementsOffset + header->numElements * elementNameSize > file.size() ||
+        header->indexOffset + header->numFrames * entrySize > file.size()) {
+        throw std::runtime_error("Caché inválido (índice fuera del archivo): " + filename);
+    }
+
+    index = file.begin() + header->indexOffset;
+    const char* names = file.begin() + header->elementsOffset;
+    for (uint64_t i = 0; i < header->numElements; ++i) {
+        const char* name = names + i * elementNameSize;
+        elements.push_back(ElementTable::intern(std::string_view(name, strnlen(name, elementNameSize))));
+    }
+}
+
+size_t FrameCache::readFrame(size_t i, FrameData& frame, const ElementMask& keepProtein,
+                           const ElementMask& keepWater) const {
+    const FrameCacheEntry& entry = this->entry(i);
+    const size_t realSize = header->realSize;
+    uint64_t offset = entry.offset;
+
+    // Cada átomo ocupa al menos un byte: con esto los tamaños de take no
+    // desbordan
+    if (entry.numAtoms > file.size() || entry.numWaters > file.size()) {
+        throw std::runtime_error("Caché inválido (frame fuera del archivo): " + filename);
+    }
+
+    // Arreglos del bloque, en el orden en que se escribieron
+    auto take = [&](uint64_t bytes) {
+        if (offset > file.size() || bytes > file.size() - offset) {
+            throw std::runtime_error("Caché inválido (frame fuera del archivo): " + filename);
+        }
+        const char* src = file.begin() + offset;
+        offset = align8(offset + bytes);
+        return src;
+    };
+
+    auto elementOf = [&](uint8_t id) {
+        if (id >= elements.size()) {
+            throw std::runtime_error("Caché inválido (elemento desconocido): " + filename);
+        }
+        return elements[id];
+    };
+
+    // Filas a copiar: nullptr si keep conserva todos los elementos del caché
+    auto selectRows = [&](const char* src, size_t n, const ElementMask& keep,
+                          std::vector<size_t>& rows) -> const std::vector<size_t>* {
+        if (std::all_of(elements.begin(), elements.end(),
+                        [&](ElementId id) { return keep.contains(id); })) {
+            return nullptr;
+        }
+        const uint8_t* ids = reinterpret_cast<const uint8_t*>(src);
+        rows.clear();
+        for (size_t k = 0; k < n; ++k) {
+            if (keep.contains(elementOf(ids[k]))) {
+                rows.push_back(k);
+            }
+        }
+        return &rows;
+    };
+
+    auto copyCoordinates = [&](const char* src, size_t n, const std::vector<size_t>* rows,
+                               std::vector<double>& values) {
+        if (realSize == sizeof(double)) {
+            const double* d = reinterpret_cast<const double*>(src);
+            if (!rows) {
+                std::memcpy(values.data(), d, n * sizeof(double));
+            } else {
+                for (size_t k = 0; k < rows->size(); ++k) values[k] = d[(*rows)[k]];
+            }
+        } else {
+            const float* f = reinterpret_cast<const float*>(src);
+            if (!rows) {
+                std::copy(f, f + n, values.begin());
+            } else {
+                for (size_t k = 0; k < rows->size(); ++k) values[k] = f[(*rows)[k]];
+            }
+        }
+    };
+    auto copyElements = [&](const char* src, const std::vector<size_t>* rows,
+                            std::vector<ElementId>& ids) {
+        const uint8_t* cacheIds = reinterpret_cast<const uint8_t*>(src);
+        for (size_t k = 0; k < ids.size(); ++k) {
+            ids[k] = elementOf(cacheIds[rows ? (*rows)[k] : k]);
+        }
+    };
+    auto copyDoubles = [&](const char* src, size_t n, const std::vector<size_t>* rows,
+                           std::vector<double>& values) {
+        const double* d = reinterpret_cast<const double*>(src);
+        if (!rows) {
+            std::memcpy(values.data(), d, n * sizeof(double));
+        } else {
+            for (size_t k = 0; k < rows->size(); ++k) values[k] = d[(*rows)[k]];
+        }
+    };
+
+    frame.frameNumber = static_cast<int>(entry.frameNumber);
+    frame.Lx = entry.Lx;
+    frame.Ly = entry.Ly;
+    frame.Lz = entry.Lz;
+    if (header->version == 1) {
+        frame.xy = frame.xz = frame.yz = 0;
+    } else {
+        frame.xy = entry.xy;
+        frame.xz = entry.xz;
+        frame.yz = entry.yz;
+    }
+
+    std::vector<size_t> rows;
+
+    // Todo el bloque se ubica (y se verifica) antes de copiar
+    const size_t numAtoms = entry.numAtoms;
+    const char* ax = take(numAtoms * realSize);
+    const char* ay = take(numAtoms * realSize);
+    const char* az = take(numAtoms * realSize);
+    const char* aIds = take(numAtoms);
+    const size_t numWaters = entry.numWaters;
+    const char* wx = take(numWaters * realSize);
+    const char* wy = take(numWaters * realSize);
+    const char* wz = take(numWaters * realSize);
+    const char* wIds = take(numWaters);
+    const char* q4 = take(numWaters * sizeof(double));
+    const char* q6 = take(numWaters * sizeof(double));
+    const char* w4 = take(numWaters * sizeof(double));
+    const char* w6 = take(numWaters * sizeof(double));
+    const std::vector<size_t>* atomRows = selectRows(aIds, numAtoms, keepProtein, rows);
+    ProteinAtoms& atoms = frame.proteinAtoms;
+    atoms.resize(atomRows ? atomRows->size() : numAtoms);
+    copyCoordinates(ax, numAtoms, atomRows, atoms.x);
+    copyCoordinates(ay, numAtoms, atomRows, atoms.y);
+    copyCoordinates(az, numAtoms, atomRows, atoms.z);
+    copyElements(aIds, atomRows, atoms.element);
+
+    const std::vector<size_t>* waterRows = selectRows(wIds, numWaters, keepWater, rows);
+    WaterMolecules& waters = frame.waterMolecules;
+    waters.resize(waterRows ? waterRows->size() : numWaters);
+    copyCoordinates(wx, numWaters, waterRows, waters.x);
+    copyCoordinates(wy, numWaters, waterRows, waters.y);
+    copyCoordinates(wz, numWaters, waterRows, waters.z);
+    copyElements(wIds, waterRows, waters.element);
+    copyDoubles(q4, numWaters, waterRows, waters.Q4);
+    copyDoubles(q6, numWaters, waterRows, waters.Q6);
+    copyDoubles(w4, numWaters, waterRows, waters.W4);
+    copyDoubles(w6, numWaters, waterRows, waters.W6);
+    return offset - entry.offset;
+}
+
+FrameCacheWriter::FrameCacheWriter(const std::string& filename_, bool singlePrecision_)
+    : filename(filename_), tempFilename(filename_ + ".tmp"),
+      out(tempFilename, std::ios::binary | std::ios::trunc),
+      singlePrecision(singlePrecision_), cacheIds(ElementTable::maxElements, -1) {
+    if (!out.is_open()) {
+        throw std::runtime_error("No se pudo crear el archivo: " + tempFilename);
+    }
+    // La cabecera definitiva se escribe en finish()
+    FrameCacheHeader header{};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+uint8_t FrameCacheWriter::elementId(ElementId element) {
+    if (cacheIds[element] >= 0) {
+        return static_cast<uint8_t>(cacheIds[element]);
+    }
+    const std::string& name = ElementTable::name(element);
+    if (name.size() >= elementNameSize) {
+        throw std::runtime_error("Nombre de elemento demasiado largo para el caché: " + name);
+    }
+    cacheIds[element] = static_cast<int>(elements.size());
+    elements.push_back(element);
+    return static_cast<uint8_t>(cacheIds[element]);
+}
+
+void FrameCacheWriter::pad() {
+    static const char zeros[8] = {};
+    out.write(zeros, align8(out.tellp()) - out.tellp());
+}
+
+void FrameCacheWriter::writeCoordinates(const std::vector<double>& values) {
+    if (singlePrecision) {
+        std::vector<float> converted(values.begin(), values.end());
+        out.write(reinterpret_cast<const char*>(converted.data()), converted.size() * sizeof(float));
+    } else {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    }
+    pad();
+}
+
+void FrameCacheWriter::addFrame(const FrameData& frame) {
+    FrameCacheEntry entry{};
+    entry.frameNumber = frame.frameNumber;
+    entry.offset = static_cast<uint64_t>(out.tellp());
+    entry.numAtoms = frame.proteinAtoms.size();
+    entry.numWaters = frame.waterMolecules.size();
+    entry.Lx = frame.Lx;
+    entry.Ly = frame.Ly;
+    entry.Lz = frame.Lz;
+    entry.xy = frame.xy;
+    entry.xz = frame.xz;
+    entry.yz = frame.yz;
+
+    auto writeElements = [&](const std::vector<ElementId>& elementIds) {
+        std::vector<uint8_t> ids(elementIds.size());
+        for (size_t k = 0; k < elementIds.size(); ++k) {
+            ids[k] = elementId(elementIds[k]);
+        }
+        out.write(reinterpret_cast<const char*>(ids.data()), ids.size());
+        pad();
+    };
+    auto writeDoubles = [&](const std::vector<double>& values) {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    };
+
+    const ProteinAtoms& atoms = frame.proteinAtoms;
+    writeCoordinates(atoms.x);
+    writeCoordinates(atoms.y);
+    writeCoordinates(atoms.z);
+    writeElements(atoms.element);
+
+    const WaterMolecules& waters = frame.waterMolecules;
+    writeCoordinates(waters.x);
+    writeCoordinates(waters.y);
+    writeCoordinates(waters.z);
+    writeElements(waters.element);
+    writeDoubles(waters.Q4);
+    writeDoubles(waters.Q6);
+    writeDoubles(waters.W4);
+    writeDoubles(waters.W6);
+
+    index.push_back(entry);
+}
+
+void FrameCacheWriter::finish() {
+    FrameCacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = FrameCache::version;
+    header.realSize = singlePrecision ? sizeof(float) : sizeof(double);
+    header.numFrames = index.size();
+
+    pad();
+    header.elementsOffset = static_cast<uint64_t>(out.tellp());
+    header.numElements = elements.size();
+    for (ElementId element : elements) {
+        const std::string& elementName = ElementTable::name(element);
+        char name[elementNameSize] = {};
+        std::memcpy(name, elementName.data(), elementName.size());
+        out.write(name, elementNameSize);
+    }
+
+    header.indexOffset = static_cast<uint64_t>(out.tellp());
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(FrameCacheEntry));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error escribiendo el caché: " + tempFilename);
+    }
+
+    std::filesystem::rename(tempFilename, filename);
+
+    // El renombrado actualiza la fecha del directorio; el caché no debe
+    // quedar más viejo que él
+    std::filesystem::path parent = std::filesystem::path(filename).parent_path();
+    if (parent.empty()) {
+        parent = ".";
+    }
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(filename, std::max(now, std::filesystem::last_write_time(parent)));
+}
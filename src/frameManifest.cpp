@@ -0,0 +1,176 @@
+// src/frameManifest.cpp
+#include "FrameManifest.h"
+#include "CompressedInput.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr const char* manifestMagic = "# bop-rdf frames v2";
+constexpr const char* manifestEnd = "# fin";
+
+// Archivo de frame reconocido por su nombre
+struct FrameFile {
+    int frameNumber;
+    bool water;
+    bool compressed;
+    std::string name;
+};
+
+// frame_N.xyz o frame_N_bop.xyz, con compresión opcional
+std::optional<FrameFile> classify(std::string_view name) {
+    std::string_view base = withoutCompression(name);
+    if (!base.starts_with("frame_") || !base.ends_with(".xyz")) {
+        return std::nullopt;
+    }
+    const bool water = base.ends_with("_bop.xyz");
+    std::string_view number = base.substr(6, base.size() - 6 - (water ? 8 : 4));
+    int frameNumber = 0;
+    auto [ptr, ec] = std::from_chars(number.data(), number.data() + number.size(), frameNumber);
+    if (ec != std::errc() || ptr != number.data() + number.size()) {
+        std::cerr << "Error extrayendo número del frame de: " << name << std::endl;
+        return std::nullopt;
+    }
+    return FrameFile{frameNumber, water, compressionOf(name) != Compression::None, std::string(name)};
+}
+
+} // namespace
+
+std::string FrameManifest::defaultPath(const std::string& directory) {
+    return (std::filesystem::path(directory) / "frames.bopindex").string();
+}
+
+FilePairs FrameManifest::scan(const std::string& directory) {
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        throw std::runtime_error("Error accediendo al directorio: " + directory);
+    }
+
+    std::vector<FrameFile> files;
+    while (dirent* entry = ::readdir(dir)) {
+        auto file = classify(entry->d_name);
+        if (!file) {
+            continue;
+        }
+        // readdir suele dar el tipo; stat sólo si no lo da o es un enlace
+        bool regular = entry->d_type == DT_REG;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat info;
+            const std::string path = directory + "/" + entry->d_name;
+            regular = ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+        }
+        if (regular) {
+            files.push_back(std::move(*file));
+        }
+    }
+    ::closedir(dir);
+
+    // Por frame: proteína antes que aguas y, de cada una, primero el
+    // archivo sin comprimir
+    std::sort(files.begin(), files.end(), [](const FrameFile& a, const FrameFile& b) {
+        return std::tie(a.frameNumber, a.water, a.compressed) <
+               std::tie(b.frameNumber, b.water, b.compressed);
+    });
+
+    const std::filesystem::path root(directory);
+    FilePairs pairs;
+    for (size_t i = 0; i < files.size();) {
+        const int frameNumber = files[i].frameNumber;
+        const FrameFile* protein = nullptr;
+        const FrameFile* water = nullptr;
+        for (; i < files.size() && files[i].frameNumber == frameNumber; ++i) {
+            const FrameFile*& slot = files[i].water ? water : protein;
+            if (!slot) {
+                slot = &files[i];
+            }
+        }
+        if (protein && water) {
+            pairs.emplace_back(frameNumber, std::make_pair((root / protein->name).string(),
+                                                           (root / water->name).string()));
+        } else if (protein) {
+            std::cerr << "Advertencia: No se encontró archivo de agua para el frame " << frameNumber << std::endl;
+        } else {
+            std::cerr << "Advertencia: No se encontró archivo de proteína para el frame " << frameNumber << std::endl;
+        }
+    }
+    return pairs;
+}
+
+std::filesystem::file_time_type FrameManifest::reserve(const std::string& manifestFile,
+                                                      const std::string& directory) {
+    // Crearlo sí cambia el directorio: tiene que pasar antes de tomar la fecha
+    std::error_code ec;
+    if (!std::filesystem::exists(manifestFile, ec)) {
+        std::ofstream create(manifestFile, std::ios::app);
+    }
+    // Si el directorio no existe, scan da el error
+    return std::filesystem::last_write_time(directory, ec);
+}
+
+std::optional<FilePairs> FrameManifest::load(const std::string& manifestFile,
+                                             const std::string& directory,
+                                             std::filesystem::file_time_type* directoryTime) {
+    std::error_code ec;
+    const auto currentTime = std::filesystem::last_write_time(directory, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+
+    std::ifstream in(manifestFile);
+    std::string line;
+    int64_t savedTime = 0;
+    size_t count = 0;
+    if (!std::getline(in, line) || line != manifestMagic || !(in >> savedTime >> count) ||
+        savedTime != currentTime.time_since_epoch().count()) {
+        return std::nullopt;
+    }
+
+    const std::filesystem::path root(directory);
+    FilePairs pairs;
+    pairs.reserve(count);
+    int frameNumber;
+    std::string protein, water;
+    while (pairs.size() < count && in >> frameNumber >> protein >> water) {
+        pairs.emplace_back(frameNumber, std::make_pair((root / protein).string(), (root / water).string()));
+    }
+    // Sin la marca final, el índice está truncado (o se está escribiendo)
+    in >> std::ws;
+    if (pairs.size() != count || !std::getline(in, line) || line != manifestEnd) {
+        return std::nullopt;
+    }
+    if (directoryTime) {
+        *directoryTime = currentTime;
+    }
+    return pairs;
+}
+
+void FrameManifest::save(const std::string& manifestFile, const FilePairs& pairs,
+                         std::filesystem::file_time_type directoryTime) {
+    // En el lugar y no vía un temporal: crear o renombrar un archivo
+    // cambiaría la fecha del directorio
+    std::ofstream out(manifestFile, std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("No se pudo crear el archivo: " + manifestFile);
+    }
+    out << manifestMagic << "\n" << directoryTime.time_since_epoch().count() << "\n"
+        << pairs.size() << "\n";
+    for (const auto& [frameNumber, files] : pairs) {
+        out << frameNumber << "\t"
+            << std::filesystem::path(files.first).filename().string() << "\t"
+            << std::filesystem::path(files.second).filename().string() << "\n";
+    }
+    out << manifestEnd << "\n";
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error escribiendo el archivo: " + manifestFile);
+    }
+}
@@ -1,27 +1,123 @@
 // src/Histogram1D.cpp
 #include "Histogram1D.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <stdexcept>
 
-Histogram1D::Histogram1D(double minDist, double maxDist, int bins)
-    : minDistance(minDist), maxDistance(maxDist),
-      numBins(bins), binWidth((maxDist - minDist) / bins) {
-    sumValues.resize(numBins, 0.0);
-    sumSquaredValues.resize(numBins, 0.0);
+// Combinación de Chan et al.: media ponderada y m2 con el término de la
+// diferencia entre medias
+void Histogram1D::Bin::merge(const Bin& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    const long long total = count + other.count;
+    const double delta = other.mean - mean;
+    mean += delta * other.count / total;
+    m2 += other.m2 + delta * delta * (static_cast<double>(count) * other.count / total);
+    count = total;
+}
+
+Histogram1D::Histogram1D(double minDist, double maxDist, int bins, size_t numShards)
+    : Histogram1D(Binning(minDist, maxDist, bins), numShards) {}
+
+Histogram1D::Histogram1D(const Binning& binning_, size_t numShards)
+    : binning(binning_), numBins(binning_.numBins()),
+      shards(std::max<size_t>(numShards, 1)) {
+    totals.resize(numBins);
     counts.resize(numBins, 0);
 }
 
-void Histogram1D::addDataPoint(double distance, double parameter) {
-    std::lock_guard<std::mutex> lock(mutex);
-    
-    if (distance >= minDistance && distance <= maxDistance) {
-        int bin = static_cast<int>((distance - minDistance) / binWidth);
-        
-        // Asegurarse de que no nos salimos de los límites
-        bin = std::min(std::max(bin, 0), numBins - 1);
-        
-        sumValues[bin] += parameter;
-        sumSquaredValues[bin] += parameter * parameter;
-        counts[bin]++;
+Histogram1D::Bin* Histogram1D::shardBins(size_t shard) {
+    std::vector<Bin>& bins = shards[shard].bins;
+    if (bins.empty()) {
+        bins.resize(numBins + paddingBins);
+    }
+    return bins.data();
+}
+
+void Histogram1D::addDataPoint(double distance, double parameter, size_t shard) {
+    int bin = binning.binOf(distance);
+    if (bin >= 0) {
+        shardBins(shard)[bin].add(parameter);
+    }
+}
+
+void Histogram1D::addDataPoints(std::span<const double> distances,
+                                std::span<const double> parameters, size_t shard) {
+    Bin* bins = shardBins(shard);
+    for (size_t i = 0; i < distances.size(); ++i) {
+        int bin = binning.binOf(distances[i]);
+        if (bin >= 0) {
+            bins[bin].add(parameters[i]);
+        }
+    }
+}
+
+void Histogram1D::mergeShards(std::span<const size_t> only) {
+    for (size_t s = 0; s < (only.empty() ? shards.size() : only.size()); ++s) {
+        std::vector<Bin>& bins = shards[only.empty() ? s : only[s]].bins;
+        for (int i = 0; i < numBins && !bins.empty(); ++i) {
+            totals[i].merge(bins[i]);
+            bins[i] = Bin();
+        }
+    }
+    for (int i = 0; i < numBins; ++i) {
+        counts[i] = totals[i].count;
+    }
+}
+
+void Histogram1D::foldShards(std::span<const size_t> group) {
+    if (group.empty()) {
+        return;
+    }
+    Bin* target = nullptr;
+    for (size_t s = 1; s < group.size(); ++s) {
+        std::vector<Bin>& bins = shards[group[s]].bins;
+        for (int i = 0; i < numBins && !bins.empty(); ++i) {
+            if (!target) {
+                target = shardBins(group[0]);
+            }
+            target[i].merge(bins[i]);
+            bins[i] = Bin();
+        }
+    }
+}
+
+void Histogram1D::save(std::ostream& out) const {
+    const int32_t bins = numBins;
+    const double minDistance = binning.lower(), maxDistance = binning.upper();
+    out.write(reinterpret_cast<const char*>(&minDistance), sizeof(minDistance));
+    out.write(reinterpret_cast<const char*>(&maxDistance), sizeof(maxDistance));
+    out.write(reinterpret_cast<const char*>(&bins), sizeof(bins));
+    if (!binning.isUniform()) {
+        binning.save(out);
+    }
+    out.write(reinterpret_cast<const char*>(totals.data()), totals.size() * sizeof(Bin));
+}
+
+void Histogram1D::load(std::istream& in) {
+    double minDist, maxDist;
+    int32_t bins;
+    in.read(reinterpret_cast<char*>(&minDist), sizeof(minDist));
+    in.read(reinterpret_cast<char*>(&maxDist), sizeof(maxDist));
+    in.read(reinterpret_cast<char*>(&bins), sizeof(bins));
+    if (!in || minDist != binning.lower() || maxDist != binning.upper() || bins != numBins ||
+        (!binning.isUniform() && !(Binning::load(in) == binning))) {
+        throw std::runtime_error("Los bins del checkpoint no coinciden con los del análisis");
+    }
+    std::vector<Bin> loaded(numBins);
+    in.read(reinterpret_cast<char*>(loaded.data()), loaded.size() * sizeof(Bin));
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado");
+    }
+    for (int i = 0; i < numBins; ++i) {
+        totals[i].merge(loaded[i]);
+        counts[i] = totals[i].count;
     }
 }
 
@@ -31,11 +127,10 @@ std::pair<std::vector<double>, std::vector<double>> Histogram1D::getAverageValue
     
     for (int i = 0; i < numBins; ++i) {
         if (counts[i] > 0) {
-            averages[i] = sumValues[i] / counts[i];
+            averages[i] = totals[i].mean;
         }
         if (counts[i] > 1) {
-            double variance = (sumSquaredValues[i] - counts[i] * averages[i] * averages[i]) / (counts[i] - 1);
-            stdDevs[i] = std::sqrt(std::max(variance, 0.0));
+            stdDevs[i] = std::sqrt(totals[i].m2 / (counts[i] - 1));
         }
     }
     
@@ -49,18 +144,24 @@ void Histogram1D::saveToFile(const std::string& filename) const {
         return;
     }
     
-    // Escribir encabezado
-    file << "# r avg_BOP std_BOP count\n";
+    // Escribir encabezado. Con bins arbitrarios, el centro lleva más
+    // decimales y los bordes de cada bin van en dos columnas al final.
+    const bool uniform = binning.isUniform();
+    file << (uniform ? "# r avg_BOP std_BOP count\n" : "# r avg_BOP std_BOP count r_low r_high\n");
     
     auto [averages, stdDevs] = getAverageValues();
     
     for (int i = 0; i < numBins; ++i) {
-        double distance = minDistance + (i + 0.5) * binWidth;
-        file << std::fixed << std::setprecision(3) 
+        double distance = getBinCenter(i);
+        file << std::fixed << std::setprecision(uniform ? 3 : 6)
              << distance << " " 
              << std::setprecision(6) << averages[i] << " "
              << stdDevs[i] << " "
-             << counts[i] << "\n";
+             << counts[i];
+        if (!uniform) {
+            file << " " << binning.lowerEdge(i) << " " << binning.upperEdge(i);
+        }
+        file << "\n";
     }
     
     file.close();
@@ -68,20 +169,20 @@ void Histogram1D::saveToFile(const std::string& filename) const {
 
 void Histogram1D::printStatistics() const {
     auto averages = getAverageValues();
-    int totalSamples = 0;
+    long long totalSamples = 0;
     
-    for (int count : counts) {
+    for (long long count : counts) {
         totalSamples += count;
     }
     
     std::cout << "Estadísticas del histograma:\n";
     std::cout << "Total de muestras: " << totalSamples << "\n";
-    std::cout << "Rango de distancia: [" << minDistance << ", " << maxDistance << "]\n";
+    std::cout << "Rango de distancia: [" << binning.lower() << ", " << binning.upper() << "]\n";
     std::cout << "Número de bins: " << numBins << "\n";
     
     // Encontrar bins no vacíos
     int nonEmptyBins = 0;
-    for (int count : counts) {
+    for (long long count : counts) {
         if (count > 0) nonEmptyBins++;
     }
     std::cout << "Bins no vacíos: " << nonEmptyBins << "/" << numBins << "\n";
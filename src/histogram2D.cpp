@@ -0,0 +1,122 @@
+// src/histogram2D.cpp
+#include "Histogram2D.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+Histogram2D::Histogram2D(double minDist, double maxDist, int distBins_,
+                         double minParam, double maxParam, int paramBins_, size_t numShards)
+    : minDistance(minDist), maxDistance(maxDist),
+      distBins(distBins_), distWidth((maxDist - minDist) / distBins_),
+      minParameter(minParam), maxParameter(maxParam),
+      paramBins(paramBins_), paramWidth((maxParam - minParam) / paramBins_),
+      counts(static_cast<size_t>(distBins_) * paramBins_, 0),
+      shards(std::max<size_t>(numShards, 1)) {}
+
+uint32_t* Histogram2D::shardCounts(size_t shard) {
+    std::vector<uint32_t>& bins = shards[shard].counts;
+    if (bins.empty()) {
+        bins.resize(counts.size() + paddingCounts, 0);
+    }
+    return bins.data();
+}
+
+void Histogram2D::spill(Shard& shard) {
+    if (shard.spilled.empty()) {
+        shard.spilled.resize(counts.size(), 0);
+    }
+    for (size_t i = 0; i < counts.size(); ++i) {
+        shard.spilled[i] += shard.counts[i];
+        shard.counts[i] = 0;
+    }
+    shard.samples = 0;
+}
+
+void Histogram2D::addDataPoints(std::span<const double> distances,
+                                std::span<const double> parameters, size_t shard) {
+    uint32_t* bins = shardCounts(shard);
+    Shard& owner = shards[shard];
+    if (owner.samples + distances.size() > std::numeric_limits<uint32_t>::max()) {
+        spill(owner);
+    }
+    owner.samples += distances.size();
+    for (size_t i = 0; i < distances.size(); ++i) {
+        const double distance = distances[i];
+        if (!(distance >= minDistance && distance <= maxDistance)) {
+            continue;
+        }
+        const int row = std::min(static_cast<int>((distance - minDistance) / distWidth), distBins - 1);
+        const double scaled = (parameters[i] - minParameter) / paramWidth;
+        const int column = scaled > 0 ? static_cast<int>(std::min(scaled, paramBins - 1.0)) : 0;
+        bins[row * paramBins + column]++;
+    }
+}
+
+void Histogram2D::mergeShards() {
+    for (auto& shard : shards) {
+        for (size_t i = 0; i < shard.counts.size() && i < counts.size(); ++i) {
+            counts[i] += shard.counts[i];
+            shard.counts[i] = 0;
+        }
+        for (size_t i = 0; i < shard.spilled.size(); ++i) {
+            counts[i] += shard.spilled[i];
+            shard.spilled[i] = 0;
+        }
+        shard.samples = 0;
+    }
+}
+
+void Histogram2D::save(std::ostream& out) const {
+    const double limits[4] = {minDistance, maxDistance, minParameter, maxParameter};
+    const int32_t bins[2] = {distBins, paramBins};
+    out.write(reinterpret_cast<const char*>(limits), sizeof(limits));
+    out.write(reinterpret_cast<const char*>(bins), sizeof(bins));
+    out.write(reinterpret_cast<const char*>(counts.data()), counts.size() * sizeof(uint64_t));
+}
+
+void Histogram2D::load(std::istream& in) {
+    double limits[4];
+    int32_t bins[2];
+    in.read(reinterpret_cast<char*>(limits), sizeof(limits));
+    in.read(reinterpret_cast<char*>(bins), sizeof(bins));
+    if (!in || limits[0] != minDistance || limits[1] != maxDistance ||
+        limits[2] != minParameter || limits[3] != maxParameter ||
+        bins[0] != distBins || bins[1] != paramBins) {
+        throw std::runtime_error("Los bins del histograma conjunto del checkpoint no coinciden");
+    }
+    std::vector<uint64_t> loaded(counts.size());
+    in.read(reinterpret_cast<char*>(loaded.data()), loaded.size() * sizeof(uint64_t));
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado");
+    }
+    for (size_t k = 0; k < counts.size(); ++k) {
+        counts[k] += loaded[k];
+    }
+}
+
+void Histogram2D::saveToFile(const std::string& filename, const std::string& parameterName) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
+        return;
+    }
+
+    file << "# P(" << parameterName << " | r): filas = bins de r, columnas = r y conteos por bin de "
+         << parameterName << "\n";
+    file << "# " << parameterName << std::fixed << std::setprecision(6);
+    for (int j = 0; j < paramBins; ++j) {
+        file << " " << minParameter + (j + 0.5) * paramWidth;
+    }
+    file << "\n";
+
+    for (int i = 0; i < distBins; ++i) {
+        file << std::setprecision(3) << minDistance + (i + 0.5) * distWidth;
+        for (int j = 0; j < paramBins; ++j) {
+            file << " " << counts[static_cast<size_t>(i) * paramBins + j];
+        }
+        file << "\n";
+    }
+}
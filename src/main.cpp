@@ -3,21 +3,142 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <sstream>
+#include <algorithm>
 
 void showUsage(const char* programName) {
     std::cout << "Uso: " << programName << " <directorio> [opciones]" << std::endl;
+    std::cout << "     " << programName << " <proteina.xyz> <bop.xyz> [opciones]" << std::endl;
+    std::cout << "     " << programName << " convert <directorio> [-o <caché>] [-f32] [-t <número>]" << std::endl;
     std::cout << "Opciones:" << std::endl;
     std::cout << "  -p <número>    Parámetro de orden a usar (1-4:Q4,Q6,W4,W6, por defecto: 2-Q6)" << std::endl;
+    std::cout << "                 Acepta una lista (-p 1,3) o all; las distancias se calculan una vez" << std::endl;
+    std::cout << "                 y se escribe un archivo por parámetro (histograma-Q4.dat, ...)" << std::endl;
+    std::cout << "  -combined      Con varios parámetros, escribir un solo archivo con todas las columnas" << std::endl;
+    std::cout << "  -2d <número>   Histograma conjunto distancia × parámetro con ese número de bins del" << std::endl;
+    std::cout << "                 parámetro, en la misma pasada (histograma-2d-Q6.dat, ...)" << std::endl;
+    std::cout << "  -prange <min>,<max> Rango del parámetro en -2d (por defecto: [0,1] para Q, [-0.2,0.2] para W)" << std::endl;
+    std::cout << "  -block <número> Promedios por bloques de ese número de frames consecutivos, con el" << std::endl;
+    std::cout << "                 error estándar entre bloques (histograma-blocks-Q6.dat, ...)" << std::endl;
+    std::cout << "  -series        Serie temporal de los promedios por bin de cada frame (histograma-series-Q6.dat, ...)" << std::endl;
     std::cout << "  -t <número>    Número de hilos (por defecto: CPUs disponibles)" << std::endl;
+    std::cout << "  -affinity <modo> Fijar los hilos a CPUs: compact (llenar un nodo NUMA antes del" << std::endl;
+    std::cout << "                 siguiente), scatter (repartirlos entre nodos) o una lista 0-15,32-47" << std::endl;
+    std::cout << "                 (por defecto: none, sin fijar)" << std::endl;
     std::cout << "  -o <archivo>   Archivo de salida (por defecto: histograma.dat)" << std::endl;
     std::cout << "  -min <valor>   Distancia mínima (por defecto: 0.0)" << std::endl;
     std::cout << "  -max <valor>   Distancia máxima (por defecto: 20.0)" << std::endl;
     std::cout << "  -bins <número> Número de bins (por defecto: 100)" << std::endl;
+    std::cout << "  -binning <esquema> Otro juego de bins, llenado con las mismas distancias: min:max:bins," << std::endl;
+    std::cout << "                 log:min:max:bins o un archivo con los bordes; repetible" << std::endl;
+    std::cout << "                 (histograma-binning1.dat, ...)" << std::endl;
+    std::cout << "  -search <modo> Búsqueda de distancias: cells (grilla de celdas) o brute" << std::endl;
+    std::cout << "                 (fuerza bruta, referencia) (por defecto: cells)" << std::endl;
+    std::cout << "  -kernel <nombre> Núcleo de distancias: auto, scalar, avx2, avx512 (por defecto: auto)" << std::endl;
+    std::cout << "  -precision <p> Precisión de la búsqueda de distancias: double o float (la mitad de" << std::endl;
+    std::cout << "                 memoria, error ~1e-5 Å; los histogramas siguen en double) (por defecto: double)" << std::endl;
+    std::cout << "  -skin <valor>  Piel de la lista de Verlet en Å: reutiliza los vecinos entre frames" << std::endl;
+    std::cout << "                 consecutivos, procesados en orden (por defecto: 0, desactivada)" << std::endl;
+    std::cout << "  -stream        Leer las aguas de cada archivo XYZ por tandas, buscando y acumulando" << std::endl;
+    std::cout << "                 cada tanda sin armar el frame: la memoria no crece con las aguas" << std::endl;
+    std::cout << "  -protein <sel> Átomos de proteína a cargar: all, heavy (sin H) o lista C,N,O" << std::endl;
+    std::cout << "                 (por defecto: all)" << std::endl;
+    std::cout << "  -water <sel>   Moléculas de agua a cargar, con la misma sintaxis (por defecto: O)" << std::endl;
+    std::cout << "  -cache <archivo> Caché binario a usar si está al día (por defecto: <directorio>/frames.bopcache)" << std::endl;
+    std::cout << "  -nocache       Ignorar el caché binario y leer siempre los archivos XYZ" << std::endl;
+    std::cout << "  -manifest <archivo> Índice de los pares de archivos, válido mientras el directorio no" << std::endl;
+    std::cout << "                 cambie (por defecto: <directorio>/frames.bopindex)" << std::endl;
+    std::cout << "  -nomanifest    Recorrer siempre el directorio, sin leer ni escribir el índice" << std::endl;
+    std::cout << "  -readers <número> Hilos lectores de archivos (por defecto: 2)" << std::endl;
+    std::cout << "  -inflight <número> Frames leídos en memoria a la vez (por defecto: 2*hilos+lectores)" << std::endl;
+    std::cout << "  -checkpoint <archivo> Guardar el estado periódicamente en ese archivo" << std::endl;
+    std::cout << "  -every <número> Frames procesados entre checkpoints (por defecto: 1000)" << std::endl;
+    std::cout << "  -resume        Continuar desde el checkpoint (por defecto: <salida>.ckpt)," << std::endl;
+    std::cout << "                 procesando sólo los frames que faltan o que aparecieron después" << std::endl;
+    std::cout << "  -progress <s>  Segundos entre reportes de avance, con frames/s y tiempo restante" << std::endl;
+    std::cout << "                 (por defecto: 5; 0 lo desactiva)" << std::endl;
+    std::cout << "  -metrics <archivo> Escribir en JSON el tiempo por etapa, CPU, memoria máxima y bytes leídos" << std::endl;
+    std::cout << "  -begin <n>, -end <n> Procesar sólo los frames con número en [begin, end)" << std::endl;
+    std::cout << "  -stride <n>    Procesar uno de cada n frames del rango (por defecto: 1)" << std::endl;
+    std::cout << "  -shard <i>/<N> Procesar la porción i (0 a N-1) de N partes contiguas de los frames" << std::endl;
+    std::cout << "                 y escribir un resultado parcial (por defecto: <salida>.<i>-<N>.part)" << std::endl;
+    std::cout << "  -partial <archivo> Escribir los acumuladores en bruto para bop-merge en lugar del histograma" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Trayectorias concatenadas:" << std::endl;
+    std::cout << "  En lugar de un directorio se pueden dar dos archivos con todos los frames" << std::endl;
+    std::cout << "  concatenados (proteína y BOP). Cada frame toma el número de su línea de" << std::endl;
+    std::cout << "  comentario (frame=N) o su posición en el archivo." << std::endl;
+    std::cout << std::endl;
+    std::cout << "Subcomando convert:" << std::endl;
+    std::cout << "  Convierte el directorio a un caché binario que las corridas siguientes" << std::endl;
+    std::cout << "  mapean en memoria en lugar de parsear los archivos de texto." << std::endl;
+    std::cout << "  -o <archivo>   Archivo de caché (por defecto: <directorio>/frames.bopcache)" << std::endl;
+    std::cout << "  -f32           Guardar las coordenadas en precisión simple" << std::endl;
     std::cout << std::endl;
     std::cout << "Ejemplo:" << std::endl;
     std::cout << "  " << programName << " /ruta/a/mis/datos -p 2 -t 8 -o resultado.csv" << std::endl;
 }
 
+// Interpreta -p: un índice, una lista separada por comas o "all"
+std::vector<int> parseParameterList(const std::string& text) {
+    if (text == "all") {
+        return {1, 2, 3, 4};
+    }
+    std::vector<int> indices;
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        int index = std::stoi(item);
+        if (index < 1 || index > 4) {
+            throw std::runtime_error("El parámetro de orden debe estar entre 1 y 4");
+        }
+        if (std::find(indices.begin(), indices.end(), index) == indices.end()) {
+            indices.push_back(index);
+        }
+    }
+    if (indices.empty()) {
+        throw std::runtime_error("Lista de parámetros de orden vacía");
+    }
+    return indices;
+}
+
+// Subcomando convert: directorio de archivos XYZ -> caché binario
+int runConvert(int argc, char* argv[]) {
+    if (argc < 3) {
+        showUsage(argv[0]);
+        return 1;
+    }
+
+    std::string directory = argv[2];
+    std::string cacheFile = FrameCache::defaultPath(directory);
+    bool singlePrecision = false;
+    int numThreads = std::thread::hardware_concurrency();
+
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            cacheFile = argv[++i];
+        } else if (arg == "-f32") {
+            singlePrecision = true;
+        } else if (arg == "-t" && i + 1 < argc) {
+            numThreads = std::stoi(argv[++i]);
+        }
+    }
+
+    if (numThreads < 1) {
+        std::cerr << "Error: El número de hilos debe ser al menos 1" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Convirtiendo " << directory << " a " << cacheFile
+              << (singlePrecision ? " (float)" : " (double)") << std::endl;
+
+    ProteinWaterAnalyzer analyzer(numThreads, 0.0, 1.0, 1, {2});
+    analyzer.setManifest(FrameManifest::defaultPath(directory));
+    analyzer.convertDirectory(directory, cacheFile, singlePrecision);
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
         showUsage(argv[0]);
@@ -25,22 +146,80 @@ int main(int argc, char* argv[]) {
     }
     
     try {
+        if (std::string(argv[1]) == "convert") {
+            return runConvert(argc, argv);
+        }
+
         // Valores por defecto
         std::string directory = argv[1];
-        int parameterIndex = 1;
+        std::string waterTrajectory;
+        int firstOption = 2;
+        if (std::filesystem::is_regular_file(directory)) {
+            // Modo trayectoria: <proteina.xyz> <bop.xyz>
+            if (argc < 3) {
+                showUsage(argv[0]);
+                return 1;
+            }
+            waterTrajectory = argv[2];
+            firstOption = 3;
+        }
+        std::vector<int> parameterIndices {1};
+        bool combinedOutput = false;
+        int parameterBins = 0;  // 0: sin histograma conjunto
+        std::optional<std::pair<double, double>> parameterRange;
+        int blockSize = 0;      // 0: sin bloques
+        bool timeSeries = false;
         int numThreads = std::thread::hardware_concurrency();
         std::string outputFile = "histograma.dat";
         double minDistance = 0.0;
         double maxDistance = 20.0;
         int distanceBins = 100;
+        SearchMode searchMode = SearchMode::CellList;
+        Precision precision = Precision::Double;
+        std::string cacheFile = FrameCache::defaultPath(directory);
+        std::string manifestFile = FrameManifest::defaultPath(directory);
+        int numReaders = 2;
+        int framesInFlight = 0;  // 0: según la cantidad de hilos
+        double skin = 0.0;
+        bool streamWaters = false;
+        std::string affinity = "none";
+        std::vector<Binning> binnings;
+        std::string proteinSelection = "all";
+        std::string waterSelection = "O";
+        std::string checkpointFile;
+        int checkpointInterval = 1000;
+        bool resume = false;
+        double progressInterval = 5.0;
+        std::string metricsFile;
+        FrameRange frameRange;
+        std::string partialFile;
         
         // Parsear argumentos
-        for (int i = 2; i < argc; i++) {
+        for (int i = firstOption; i < argc; i++) {
             std::string arg = argv[i];
             if (arg == "-p" && i + 1 < argc) {
-                parameterIndex = std::stoi(argv[++i]);
+                parameterIndices = parseParameterList(argv[++i]);
+            } else if (arg == "-combined") {
+                combinedOutput = true;
+            } else if (arg == "-2d" && i + 1 < argc) {
+                parameterBins = std::stoi(argv[++i]);
+            } else if (arg == "-block" && i + 1 < argc) {
+                blockSize = std::stoi(argv[++i]);
+            } else if (arg == "-series") {
+                timeSeries = true;
+            } else if (arg == "-prange" && i + 1 < argc) {
+                std::string range = argv[++i];
+                size_t comma = range.find(',');
+                if (comma == std::string::npos) {
+                    std::cerr << "Error: -prange espera <min>,<max>" << std::endl;
+                    return 1;
+                }
+                parameterRange = std::pair(std::stod(range.substr(0, comma)),
+                                           std::stod(range.substr(comma + 1)));
             } else if (arg == "-t" && i + 1 < argc) {
                 numThreads = std::stoi(argv[++i]);
+            } else if (arg == "-affinity" && i + 1 < argc) {
+                affinity = argv[++i];
             } else if (arg == "-o" && i + 1 < argc) {
                 outputFile = argv[++i];
             } else if (arg == "-min" && i + 1 < argc) {
@@ -49,6 +228,82 @@ int main(int argc, char* argv[]) {
                 maxDistance = std::stod(argv[++i]);
             } else if (arg == "-bins" && i + 1 < argc) {
                 distanceBins = std::stoi(argv[++i]);
+            } else if (arg == "-binning" && i + 1 < argc) {
+                binnings.push_back(Binning::parse(argv[++i]));
+            } else if (arg == "-search" && i + 1 < argc) {
+                std::string mode = argv[++i];
+                if (mode == "cells") {
+                    searchMode = SearchMode::CellList;
+                } else if (mode == "brute") {
+                    searchMode = SearchMode::BruteForce;
+                } else {
+                    std::cerr << "Error: Modo de búsqueda desconocido: " << mode << std::endl;
+                    return 1;
+                }
+            } else if (arg == "-precision" && i + 1 < argc) {
+                std::string name = argv[++i];
+                if (name == "double") {
+                    precision = Precision::Double;
+                } else if (name == "float") {
+                    precision = Precision::Float;
+                } else {
+                    std::cerr << "Error: Precisión desconocida: " << name << std::endl;
+                    return 1;
+                }
+            } else if (arg == "-skin" && i + 1 < argc) {
+                skin = std::stod(argv[++i]);
+            } else if (arg == "-stream") {
+                streamWaters = true;
+            } else if (arg == "-protein" && i + 1 < argc) {
+                proteinSelection = argv[++i];
+            } else if (arg == "-water" && i + 1 < argc) {
+                waterSelection = argv[++i];
+            } else if (arg == "-kernel" && i + 1 < argc) {
+                selectDistanceKernel(argv[++i]);
+            } else if (arg == "-cache" && i + 1 < argc) {
+                cacheFile = argv[++i];
+            } else if (arg == "-nocache") {
+                cacheFile.clear();
+            } else if (arg == "-manifest" && i + 1 < argc) {
+                manifestFile = argv[++i];
+            } else if (arg == "-nomanifest") {
+                manifestFile.clear();
+            } else if (arg == "-readers" && i + 1 < argc) {
+                numReaders = std::stoi(argv[++i]);
+            } else if (arg == "-inflight" && i + 1 < argc) {
+                framesInFlight = std::stoi(argv[++i]);
+            } else if (arg == "-checkpoint" && i + 1 < argc) {
+                checkpointFile = argv[++i];
+            } else if (arg == "-every" && i + 1 < argc) {
+                checkpointInterval = std::stoi(argv[++i]);
+            } else if (arg == "-resume" || arg == "--resume") {
+                resume = true;
+            } else if (arg == "-progress" && i + 1 < argc) {
+                progressInterval = std::stod(argv[++i]);
+            } else if (arg == "-metrics" && i + 1 < argc) {
+                metricsFile = argv[++i];
+            } else if ((arg == "-begin" || arg == "--begin") && i + 1 < argc) {
+                frameRange.begin = std::stoi(argv[++i]);
+            } else if ((arg == "-end" || arg == "--end") && i + 1 < argc) {
+                frameRange.end = std::stoi(argv[++i]);
+            } else if ((arg == "-stride" || arg == "--stride") && i + 1 < argc) {
+                frameRange.stride = std::stoi(argv[++i]);
+            } else if ((arg == "-shard" || arg == "--shard") && i + 1 < argc) {
+                // i/N, con i de 0 a N-1
+                std::string shard = argv[++i];
+                size_t slash = shard.find('/');
+                if (slash == std::string::npos) {
+                    throw std::runtime_error("-shard espera i/N: " + shard);
+                }
+                int index = std::stoi(shard.substr(0, slash));
+                int count = std::stoi(shard.substr(slash + 1));
+                if (count < 1 || index < 0 || index >= count) {
+                    throw std::runtime_error("-shard espera i/N con 0 <= i < N: " + shard);
+                }
+                frameRange.shard = index;
+                frameRange.numShards = count;
+            } else if (arg == "-partial" && i + 1 < argc) {
+                partialFile = argv[++i];
             } else if (arg == "-h" || arg == "--help") {
                 showUsage(argv[0]);
                 return 0;
@@ -56,41 +311,170 @@ int main(int argc, char* argv[]) {
         }
         
         // Validar parámetros
-        if (parameterIndex < 1 || parameterIndex > 4) {
-            std::cerr << "Error: El parámetro de orden debe estar entre 1 y 4" << std::endl;
-            return 1;
-        }
-        
         if (numThreads < 1) {
             std::cerr << "Error: El número de hilos debe ser al menos 1" << std::endl;
             return 1;
         }
+        if (parameterBins < 0) {
+            std::cerr << "Error: El número de bins del parámetro no puede ser negativo" << std::endl;
+            return 1;
+        }
+        if (parameterRange && !(parameterRange->first < parameterRange->second)) {
+            std::cerr << "Error: El rango del parámetro debe cumplir min < max" << std::endl;
+            return 1;
+        }
+        if (blockSize < 0) {
+            std::cerr << "Error: El tamaño de bloque no puede ser negativo" << std::endl;
+            return 1;
+        }
+        if (skin < 0) {
+            std::cerr << "Error: La piel de la lista de Verlet no puede ser negativa" << std::endl;
+            return 1;
+        }
+        if (skin > 0 && searchMode != SearchMode::CellList) {
+            std::cerr << "Advertencia: -skin sólo se usa con -search cells" << std::endl;
+        }
+        if (skin > 0 && precision != Precision::Double) {
+            std::cerr << "Error: -skin requiere -precision double" << std::endl;
+            return 1;
+        }
+        if (skin > 0 && streamWaters) {
+            std::cerr << "Error: -skin no se puede combinar con -stream" << std::endl;
+            return 1;
+        }
+        if (numReaders < 1 || framesInFlight < 0) {
+            std::cerr << "Error: Se necesita al menos un lector y un frame en memoria" << std::endl;
+            return 1;
+        }
+        if (framesInFlight == 0) {
+            framesInFlight = 2 * numThreads + numReaders;
+        }
+        if (checkpointInterval < 1) {
+            std::cerr << "Error: El intervalo entre checkpoints debe ser al menos 1" << std::endl;
+            return 1;
+        }
+        if (resume && checkpointFile.empty()) {
+            checkpointFile = outputFile + ".ckpt";
+        }
+        if (progressInterval < 0) {
+            std::cerr << "Error: El intervalo de avance no puede ser negativo" << std::endl;
+            return 1;
+        }
+        if (frameRange.stride < 1 || frameRange.begin >= frameRange.end) {
+            std::cerr << "Error: El rango de frames debe cumplir begin < end y stride >= 1" << std::endl;
+            return 1;
+        }
+        if (frameRange.numShards > 1 && partialFile.empty()) {
+            partialFile = outputFile + "." + std::to_string(frameRange.shard) + "-" +
+                          std::to_string(frameRange.numShards) + ".part";
+        }
         
-        std::string p2bop[] {"Q4", "Q6", "W4", "W6"};
         std::cout << "Iniciando análisis con los siguientes parámetros:" << std::endl;
-        std::cout << "  Directorio: " << directory << std::endl;
+        if (waterTrajectory.empty()) {
+            std::cout << "  Directorio: " << directory << std::endl;
+        } else {
+            std::cout << "  Trayectorias: " << directory << ", " << waterTrajectory << std::endl;
+        }
         std::cout << "  Hilos: " << numThreads << std::endl;
-        std::cout << "  Parámetro de orden: " << p2bop[parameterIndex - 1] << std::endl;
+        if (affinity != "none") {
+            std::cout << "  Afinidad: " << affinity << std::endl;
+        }
+        std::cout << "  Parámetro de orden:";
+        for (int parameterIndex : parameterIndices) {
+            std::cout << " " << bopName(parameterIndex);
+        }
+        std::cout << std::endl;
         std::cout << "  Rango de distancia: [" << minDistance << ", " << maxDistance << "]" << std::endl;
         std::cout << "  Bins: " << distanceBins << std::endl;
-        std::cout << "  Archivo de salida: " << outputFile << std::endl;
+        for (const auto& binning : binnings) {
+            std::cout << "  Bins adicionales: " << binning.describe() << std::endl;
+        }
+        if (blockSize > 0) {
+            std::cout << "  Bloques: " << blockSize << " frames" << std::endl;
+        }
+        if (parameterBins > 0) {
+            std::cout << "  Histograma conjunto: " << parameterBins << " bins del parámetro" << std::endl;
+        }
+        std::cout << "  Búsqueda: " << (searchMode == SearchMode::CellList ? "cells" : "brute") << std::endl;
+        std::cout << "  Núcleo de distancias: " << distanceKernelName()
+                  << (precision == Precision::Float ? " (float)" : " (double)") << std::endl;
+        if (skin > 0) {
+            std::cout << "  Lista de Verlet: piel " << skin << " Å" << std::endl;
+        }
+        if (streamWaters) {
+            std::cout << "  Aguas: por tandas (-stream)" << std::endl;
+        }
+        std::cout << "  Selección: proteína " << proteinSelection << ", aguas " << waterSelection << std::endl;
+        std::cout << "  Lectores: " << numReaders << " (" << framesInFlight << " frames en memoria)" << std::endl;
+        if (frameRange.numShards > 1) {
+            std::cout << "  Shard: " << frameRange.shard << "/" << frameRange.numShards << std::endl;
+        }
+        std::cout << "  Archivo de salida: " << (partialFile.empty() ? outputFile : partialFile) << std::endl;
+        if (!checkpointFile.empty()) {
+            std::cout << "  Checkpoint: " << checkpointFile << " (cada " << checkpointInterval
+                      << " frames)" << std::endl;
+        }
         std::cout << std::endl;
         
         // Crear analizador
-        ProteinWaterAnalyzer analyzer(numThreads, minDistance, maxDistance, distanceBins);
+        ProteinWaterAnalyzer analyzer(numThreads, minDistance, maxDistance, distanceBins,
+                                      parameterIndices, searchMode);
+        analyzer.setPipeline(numReaders, framesInFlight);
+        if (size_t nodes = analyzer.setAffinity(affinity); nodes > 0) {
+            std::cout << "Hilos fijados en " << nodes << (nodes == 1 ? " nodo" : " nodos") << " NUMA"
+                      << std::endl;
+        }
+        analyzer.setProgressInterval(progressInterval);
+        analyzer.setFrameRange(frameRange);
+        analyzer.setManifest(manifestFile);
+        analyzer.setPrecision(precision);
+        analyzer.setSkin(skin);
+        analyzer.setStreamWaters(streamWaters);
+        if (parameterBins > 0) {
+            analyzer.enableJointHistogram(parameterBins, parameterRange);
+        }
+        if (blockSize > 0 || timeSeries) {
+            analyzer.enableBlockAverages(blockSize, timeSeries);
+        }
+        for (const auto& binning : binnings) {
+            analyzer.addBinning(binning);
+        }
+        if (!checkpointFile.empty()) {
+            analyzer.setCheckpoint(checkpointFile, checkpointInterval);
+        }
+        if (resume) {
+            size_t done = analyzer.resume();
+            std::cout << "Checkpoint cargado: " << done << " frames ya procesados" << std::endl;
+        }
+        analyzer.setSelection(ElementMask::parse(proteinSelection), ElementMask::parse(waterSelection));
         
-        // Procesar directorio
-        analyzer.processDirectory(directory, parameterIndex);
+        // Procesar directorio o trayectorias
+        if (waterTrajectory.empty()) {
+            analyzer.processDirectory(directory, cacheFile);
+        } else {
+            analyzer.processTrajectory(directory, waterTrajectory);
+        }
         
         // Esperar a que terminen todos los trabajos
         std::cout << "Esperando a que terminen todos los trabajos..." << std::endl;
         analyzer.wait(); // sincronización de tareas
 
-        std::cout << "Guardando histograma..." << std::endl;
-        analyzer.saveHistogram(outputFile);
+        // Un shard deja sus acumuladores en bruto; bop-merge los combina
+        if (!partialFile.empty()) {
+            std::cout << "Guardando resultado parcial en: " << partialFile << std::endl;
+            analyzer.writePartial(partialFile);
+        } else {
+            std::cout << "Guardando histograma..." << std::endl;
+            analyzer.saveHistogram(outputFile, combinedOutput);
+        }
         
         // Mostrar estadísticas
         analyzer.printStatistics();
+
+        if (!metricsFile.empty()) {
+            analyzer.writeMetrics(metricsFile);
+            std::cout << "Métricas escritas en: " << metricsFile << std::endl;
+        }
         
         std::cout << "Análisis completado exitosamente!" << std::endl;
         
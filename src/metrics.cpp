@@ -0,0 +1,145 @@
+// src/metrics.cpp
+#include "Metrics.h"
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/resource.h>
+
+const char* stageName(Stage stage) {
+    static const char* names[] = {"discovery", "read", "search", "histogram", "output"};
+    return names[static_cast<size_t>(stage)];
+}
+
+uint64_t Metrics::threadCpuNs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+Metrics::Metrics() : start(std::chrono::steady_clock::now()) {}
+
+Metrics::Slot& Metrics::slotOf(std::array<Slot, numSlots>& slots) {
+    // Ranura fija por hilo, asignada la primera vez que mide algo
+    static std::atomic<size_t> nextSlot{0};
+    thread_local size_t slot = nextSlot++ % numSlots;
+    return slots[slot];
+}
+
+Metrics::Timer::~Timer() {
+    const auto wall = std::chrono::steady_clock::now() - wallStart;
+    const uint64_t cpu = threadCpuNs() - cpuStart;
+    Slot& slot = slotOf(metrics.slots);
+    const size_t s = static_cast<size_t>(stage);
+    slot.wallNs[s].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count(),
+                             std::memory_order_relaxed);
+    slot.cpuNs[s].fetch_add(cpu, std::memory_order_relaxed);
+    slot.calls[s].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::addBytesRead(uint64_t bytes) {
+    slotOf(slots).bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint64_t Metrics::bytesRead() {
+    uint64_t total = 0;
+    for (const Slot& slot : slots) {
+        total += slot.bytesRead.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double Metrics::elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Metrics::report(const std::string& filename, size_t threads, size_t frames) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("No se pudo crear el archivo: " + filename);
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const double cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+                              usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+    const double wallSeconds = elapsed();
+
+    file << std::setprecision(6);
+    file << "{\n";
+    file << "  \"wall_seconds\": " << wallSeconds << ",\n";
+    file << "  \"cpu_seconds\": " << cpuSeconds << ",\n";
+    file << "  \"peak_rss_bytes\": " << static_cast<uint64_t>(usage.ru_maxrss) * 1024 << ",\n";
+    file << "  \"threads\": " << threads << ",\n";
+    file << "  \"frames\": " << frames << ",\n";
+    file << "  \"frames_per_s\": " << (wallSeconds > 0 ? frames / wallSeconds : 0.0) << ",\n";
+    file << "  \"bytes_read\": " << bytesRead() << ",\n";
+    file << "  \"stages\": {\n";
+    for (size_t s = 0; s < numStages; ++s) {
+        uint64_t wall = 0, cpu = 0, calls = 0;
+        for (const Slot& slot : slots) {
+            wall += slot.wallNs[s].load(std::memory_order_relaxed);
+            cpu += slot.cpuNs[s].load(std::memory_order_relaxed);
+            calls += slot.calls[s].load(std::memory_order_relaxed);
+        }
+        file << "    \"" << stageName(static_cast<Stage>(s)) << "\": {"
+             << "\"wall_seconds\": " << wall * 1e-9
+             << ", \"cpu_seconds\": " << cpu * 1e-9
+             << ", \"calls\": " << calls << "}"
+             << (s + 1 < numStages ? "," : "") << "\n";
+    }
+    file << "  }\n";
+    file << "}\n";
+}
+
+ProgressReporter::ProgressReporter(const std::atomic<int>& p, size_t t, double i)
+    : processed(p), total(t), interval(i), start(std::chrono::steady_clock::now()),
+      stopping(false) {
+    if (interval > 0) {
+        thread = std::thread(&ProgressReporter::run, this);
+    }
+}
+
+ProgressReporter::~ProgressReporter() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopped.notify_one();
+    thread.join();
+}
+
+void ProgressReporter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto period = std::chrono::duration<double>(interval);
+    while (!stopped.wait_for(lock, period, [this]() { return stopping; })) {
+        print(false);
+    }
+    print(true);
+}
+
+void ProgressReporter::print(bool last) {
+    const int done = processed.load();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rate = seconds > 0 ? done / seconds : 0.0;
+
+    // Una sola escritura por línea: no se mezcla con los mensajes de error
+    std::ostringstream line;
+    line << "Procesados " << done;
+    if (total > 0) {
+        line << "/" << total;
+    }
+    line << " frames (" << std::fixed << std::setprecision(1) << rate << " frames/s";
+    if (!last && total > 0 && rate > 0 && static_cast<size_t>(done) < total) {
+        const long remaining = static_cast<long>((total - done) / rate);
+        line << ", faltan " << remaining / 3600 << ":" << std::setfill('0') << std::setw(2)
+             << remaining / 60 % 60 << ":" << std::setw(2) << remaining % 60;
+    }
+    line << ")\n";
+    std::cout << line.str() << std::flush;
+}
@@ -1,227 +1,382 @@
 // src/ProteinWaterAnalyzer.cpp
 #include "ProteinWaterAnalyzer.h"
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+// Checkpoint o resultado parcial (orden de bytes nativo): cabecera,
+// índices de los parámetros (int32), rango del parámetro de cada histograma
+// conjunto (2 double), desde la versión 3 los esquemas de bins adicionales
+// (cantidad y bordes de cada uno), números de los frames procesados
+// (int32), el estado de cada Histogram1D y de cada Histogram2D, con
+// bloques sus sumas y, al final, los histogramas de los esquemas
+// adicionales. La cabecera alcanza para reconstruir el analizador
+// (bop-merge).
+struct CheckpointHeader {
+    char magic[8];             // "BOPCKPT"
+    uint32_t version;
+    uint32_t numParameters;
+    uint32_t numJoint;         // Histogramas conjuntos (0 sin -2d)
+    uint32_t blockSize;        // Frames por bloque (0 sin -block)
+    uint64_t numFrames;
+    double minDistance, maxDistance;
+    uint32_t distanceBins;
+    uint32_t jointBins;        // Bins del parámetro en -2d
+};
+
+constexpr char checkpointMagic[8] = {'B', 'O', 'P', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t checkpointVersion = 3;
+
+// Lee la cabecera, los parámetros, los rangos de los histogramas conjuntos
+// y los esquemas de bins adicionales (ninguno en la versión 2); deja in al
+// comienzo de los números de frame
+CheckpointHeader readCheckpointHeader(std::istream& in, const std::string& filename,
+                                      std::vector<int32_t>& parameters,
+                                      std::vector<double>& jointRanges,
+                                      std::vector<Binning>& binnings) {
+    CheckpointHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)) != 0) {
+        throw std::runtime_error("Checkpoint inválido: " + filename);
+    }
+    if (header.version != checkpointVersion && header.version != 2) {
+        throw std::runtime_error("Versión de checkpoint no soportada en " + filename +
+                                 ": " + std::to_string(header.version));
+    }
+    parameters.resize(header.numParameters);
+    in.read(reinterpret_cast<char*>(parameters.data()), parameters.size() * sizeof(int32_t));
+    jointRanges.resize(2 * header.numJoint);
+    in.read(reinterpret_cast<char*>(jointRanges.data()), jointRanges.size() * sizeof(double));
+    uint32_t numBinnings = 0;
+    if (header.version >= 3) {
+        in.read(reinterpret_cast<char*>(&numBinnings), sizeof(numBinnings));
+    }
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado: " + filename);
+    }
+    binnings.clear();
+    for (uint32_t b = 0; b < numBinnings; ++b) {
+        binnings.push_back(Binning::load(in));
+    }
+    return header;
+}
+
+} // namespace
 
 ProteinWaterAnalyzer::ProteinWaterAnalyzer(size_t numThreads, 
                         double minDist, double maxDist, 
-                        int bins)
+                        int bins, const std::vector<int>& parameters,
+                        SearchMode mode)
     : pool(numThreads), 
-      histogram(minDist, maxDist, bins),
-      processedFrames(0), totalFrames(0) {}
-
-double ProteinWaterAnalyzer::calculateMinDistance(const WaterMolecule& water, 
-                               const std::vector<ProteinAtom>& proteinAtoms,
-                               double Lx, double Ly, double Lz) {
-    double minDist = std::numeric_limits<double>::max();
-    
-    for (const auto& atom : proteinAtoms) {
-        double dx = water.x - atom.x;
-        double dy = water.y - atom.y;
-        double dz = water.z - atom.z;
-        
-        // Aplicar condiciones periódicas de contorno
-        dx -= Lx * std::round(dx / Lx);
-        dy -= Ly * std::round(dy / Ly);
-        dz -= Lz * std::round(dz / Lz);
-        
-        double dist = std::sqrt(dx*dx + dy*dy + dz*dz);
-        minDist = std::min(minDist, dist);
+      parameterIndices(parameters),
+      processedFrames(0), totalFrames(0),
+      searchMode(mode), precision(Precision::Double), minDistance(minDist), maxDistance(maxDist), distanceBins(bins),
+      searchDistance(maxDist),
+      numReaders(2), framesInFlight(2 * numThreads + 2),
+      proteinSelection(ElementMask::all()), waterSelection(ElementMask::parse("O")),
+      streamWaters(false), checkpointInterval(0), checkpointedFrames(0), progressInterval(5.0) {
+    for (size_t i = 0; i < parameterIndices.size(); ++i) {
+        histograms.emplace_back(minDist, maxDist, bins, numThreads);
     }
-    
-    return minDist;
 }
 
-FrameData ProteinWaterAnalyzer::readProteinFile(const std::string& filename, int frameNumber) {
-    FrameData frame(frameNumber);
-    std::ifstream file(filename);
-    
-    if (!file.is_open()) {
-        throw std::runtime_error("No se pudo abrir el archivo: " + filename);
-    }
-    
-    int numAtoms;
-    file >> numAtoms;
-    
-    std::string line;
-    std::getline(file, line); // Leer el resto de la primera línea
-    std::getline(file, line); // Leer línea de dimensiones
-    
-    // Parsear dimensiones
-    std::istringstream dimStream(line);
-    std::string token;
-    while (dimStream >> token) {
-        if (token.find("Lx=") != std::string::npos) {
-            frame.Lx = std::stod(token.substr(3));
-        } else if (token.find("Ly=") != std::string::npos) {
-            frame.Ly = std::stod(token.substr(3));
-        } else if (token.find("Lz=") != std::string::npos) {
-            frame.Lz = std::stod(token.substr(3));
+template <typename Real>
+void ProteinWaterAnalyzer::calculateMinDistances(const Real* ax, const Real* ay, const Real* az,
+                               size_t numAtoms, const double* wx, const double* wy, const double* wz,
+                               size_t numWaters, const PeriodicBox& box, double* minDist) {
+    // El núcleo reduce sobre la distancia al cuadrado
+    if constexpr (std::is_same_v<Real, double>) {
+        std::fill(minDist, minDist + numWaters, std::numeric_limits<double>::max());
+        distanceKernel<double>(box.kind)(ax, ay, az, numAtoms, wx, wy, wz, numWaters, box, minDist);
+        for (size_t i = 0; i < numWaters; ++i) {
+            minDist[i] = std::sqrt(minDist[i]);
+        }
+    } else {
+        // Las aguas del bloque se pasan a Real en buffers del worker
+        thread_local std::vector<Real> x, y, z, minDist2;
+        x.assign(wx, wx + numWaters);
+        y.assign(wy, wy + numWaters);
+        z.assign(wz, wz + numWaters);
+        minDist2.assign(numWaters, std::numeric_limits<Real>::max());
+        distanceKernel<Real>(box.kind)(ax, ay, az, numAtoms, x.data(), y.data(), z.data(), numWaters,
+                                       box, minDist2.data());
+        for (size_t i = 0; i < numWaters; ++i) {
+            minDist[i] = std::sqrt(static_cast<double>(minDist2[i]));
         }
     }
-    
-    // Leer átomos
-    for (int i = 0; i < numAtoms; ++i) {
-        std::string element;
-        double x, y, z;
-        file >> element >> x >> y >> z;
-        frame.proteinAtoms.emplace_back(element, x, y, z);
+}
+
+void ProteinWaterAnalyzer::readXyzFile(const std::string& filename,
+                                       const std::function<void(XyzParser&)>& parse) {
+    Metrics::Timer timer(metrics, Stage::Read);
+    withXyzFile(filename, parse);
+}
+
+void ProteinWaterAnalyzer::withXyzFile(const std::string& filename,
+                                       const std::function<void(XyzParser&)>& parse) {
+    if (compressionOf(filename) == Compression::None) {
+        MappedFile file(filename);
+        XyzParser parser(file.begin(), file.end(), filename);
+        parse(parser);
+        metrics.addBytesRead(file.size());
+        return;
     }
-    
-    file.close();
-    return frame;
+
+    // Los archivos comprimidos se descomprimen enteros en un buffer del
+    // hilo lector, que se reutiliza entre frames
+    thread_local std::vector<char> buffer;
+    metrics.addBytesRead(decompressFile(filename, buffer));
+    XyzParser parser(buffer.data(), buffer.data() + buffer.size(), filename);
+    parse(parser);
 }
 
-void ProteinWaterAnalyzer::readWaterFile(const std::string& filename, FrameData& frame) {
-    std::ifstream file(filename);
-    
-    if (!file.is_open()) {
-        throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+void ProteinWaterAnalyzer::readProteinFile(const std::string& filename, FrameData& frame,
+                                           const ElementMask& keep) {
+    readXyzFile(filename, [&](XyzParser& parser) { parser.parseProteinFrame(frame, keep); });
+}
+
+void ProteinWaterAnalyzer::readWaterFile(const std::string& filename, FrameData& frame,
+                                         const ElementMask& keep) {
+    readXyzFile(filename, [&](XyzParser& parser) { parser.parseWaterFrame(frame, keep); });
+}
+
+std::vector<std::pair<int, std::pair<std::string, std::string>>> ProteinWaterAnalyzer::findFilePairs(const std::string& directory) {
+    Metrics::Timer timer(metrics, Stage::Discovery);
+
+    // El índice evita recorrer el directorio mientras éste no cambie
+    listedTime.reset();
+    std::filesystem::file_time_type directoryTime;
+    std::optional<FilePairs> manifest;
+    if (!manifestFile.empty()) {
+        manifest = FrameManifest::load(manifestFile, directory, &directoryTime);
     }
-    
-    int numMolecules;
-    file >> numMolecules;
-    
-    std::string line;
-    std::getline(file, line); // Leer el resto de la primera línea
-    
-    // Leer moléculas de agua
-    for (int i = 0; i < numMolecules; ++i) {
-        std::string element;
-        double x, y, z, q4, q6, w4, w6;
-        file >> element >> x >> y >> z >> q4 >> q6 >> w4 >> w6;
-        frame.waterMolecules.emplace_back(element, x, y, z, q4, q6, w4, w6);
+    if (manifest) {
+        std::cout << "Encontrados " << manifest->size() << " pares de archivos válidos (índice: "
+                  << manifestFile << ")" << std::endl;
+        listedTime = directoryTime;
+        return std::move(*manifest);
     }
-    
-    file.close();
+
+    // La fecha se toma antes de recorrer: un frame agregado durante el
+    // recorrido o antes de guardar el índice la cambia y lo invalida
+    if (!manifestFile.empty()) {
+        directoryTime = FrameManifest::reserve(manifestFile, directory);
+    }
+    FilePairs filePairs = FrameManifest::scan(directory);
+    std::cout << "Encontrados " << filePairs.size() << " pares de archivos válidos" << std::endl;
+    if (!manifestFile.empty() && !filePairs.empty()) {
+        // Un directorio de sólo lectura no impide el análisis
+        try {
+            FrameManifest::save(manifestFile, filePairs, directoryTime);
+            listedTime = directoryTime;
+        } catch (const std::exception& e) {
+            std::cerr << "Advertencia: No se pudo escribir el índice de frames: " << e.what() << std::endl;
+        }
+    }
+    return filePairs;
 }
 
-// Encontrar archivos de proteína (frame_XXX.xyz)
-std::vector<std::pair<int, std::string>> ProteinWaterAnalyzer::findProteinFiles(const std::string& directory) {
-    std::vector<std::pair<int, std::string>> proteinFiles;
-    
-    try {
-        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-            if (entry.is_regular_file()) {
-                std::string filename = entry.path().filename().string();
-                
-                // Buscar archivos que coincidan con el patrón frame_XXX.xyz
-                if (filename.find("frame_") == 0 && filename.find("_bop") == std::string::npos) {
-                    // Extraer el número del frame
-                    std::string numberStr = filename.substr(6, filename.find(".xyz") - 6);
-                    try {
-                        int frameNumber = std::stoi(numberStr);
-                        proteinFiles.emplace_back(frameNumber, entry.path().string());
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error extrayendo número del frame de: " << filename << std::endl;
-                    }
-                }
-            }
+std::shared_ptr<ProteinWaterAnalyzer::FrameWork> ProteinWaterAnalyzer::prepareFrame(const FrameView& frame) {
+    // Las aguas ya vienen filtradas al leer (sólo oxígenos, por defecto)
+    const PositionsView& waters = frame.waters;
+    auto work = std::make_shared<FrameWork>(frame);
+    if (blockAverages) {
+        work->frameBins = blockAverages->emptyFrame();
+    }
+
+    // La grilla necesita una caja periódica (ortorrómbica o triclínica); sin
+    // caja se usa la fuerza bruta sin imagen mínima. Con la lista de Verlet
+    // sólo se arma si alguna agua necesita búsqueda completa.
+    if (searchMode == SearchMode::CellList && work->box.kind != BoxKind::None) {
+        Metrics::Timer timer(metrics, Stage::Search);
+        work->useVerlet = verlet != nullptr;
+        if (precision == Precision::Float) {
+            work->cellsFloat.emplace(frame.protein, work->box, cellSize);
+        } else if (!work->useVerlet ||
+            verlet->beginFrame(frame.protein, work->box, waters.x.data(), waters.y.data(),
+                               waters.z.data(), waters.size()) > 0) {
+            work->cells.emplace(frame.protein, work->box, cellSize);
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        throw std::runtime_error("Error accediendo al directorio: " + std::string(e.what()));
+    } else if (precision == Precision::Float) {
+        // Fuerza bruta: la proteína se convierte una vez por frame
+        const PositionsView& atoms = frame.protein;
+        work->atomX.assign(atoms.x.begin(), atoms.x.end());
+        work->atomY.assign(atoms.y.begin(), atoms.y.end());
+        work->atomZ.assign(atoms.z.begin(), atoms.z.end());
     }
-    
-    // Ordenar por número de frame
-    std::sort(proteinFiles.begin(), proteinFiles.end(), 
-              [](const auto& a, const auto& b) { return a.first < b.first; });
-    
-    return proteinFiles;
+    return work;
 }
 
-// Encontrar archivos de agua (frame_XXX_bop.xyz)
-std::vector<std::pair<int, std::string>> ProteinWaterAnalyzer::findWaterFiles(const std::string& directory) {
-    std::vector<std::pair<int, std::string>> waterFiles;
-    
+void ProteinWaterAnalyzer::analyzeFrame(const FrameView& frame, std::function<void(bool ok)> release) {
+    auto work = prepareFrame(frame);
+    work->release = std::move(release);
+
+    // Los frames grandes se parten en bloques de aguas que se encolan en
+    // este worker; los workers ociosos los roban. El primer bloque se
+    // calcula aquí mismo y el último en terminar cierra el frame.
+    const size_t numWaters = frame.waters.size();
+    const size_t numChunks = pool.size() > 1 ? std::max<size_t>((numWaters + waterChunk - 1) / waterChunk, 1) : 1;
+    work->remaining = numChunks;
+    for (size_t c = 1; c < numChunks; ++c) {
+        const size_t begin = c * numWaters / numChunks;
+        const size_t end = (c + 1) * numWaters / numChunks;
+        pool.enqueue([this, work, begin, end]() {
+            analyzeChunk(*work, begin, end);
+        });
+    }
+    analyzeChunk(*work, 0, numWaters / numChunks);
+}
+
+void ProteinWaterAnalyzer::analyzeStreamedFrame(const FrameData& frame, const std::string& waterFile,
+                                                std::function<void(bool ok)> release) {
+    auto work = prepareFrame(frame.view());
+    work->release = std::move(release);
+
+    // Las aguas se leen por tandas de streamChunk moléculas en buffers del
+    // worker: cada tanda se parsea, se busca y se acumula mientras todavía
+    // está en caché, y el arreglo de aguas del frame nunca se arma
+    thread_local WaterMolecules chunk;
+    thread_local std::vector<double> distances;
     try {
-        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-            if (entry.is_regular_file()) {
-                std::string filename = entry.path().filename().string();
-                
-                // Buscar archivos que coincidan con el patrón frame_XXX_bop.xyz
-                if (filename.find("frame_") == 0 && filename.find("_bop.xyz") != std::string::npos) {
-                    // Extraer el número del frame
-                    std::string numberStr = filename.substr(6, filename.find("_bop.xyz") - 6);
-                    try {
-                        int frameNumber = std::stoi(numberStr);
-                        waterFiles.emplace_back(frameNumber, entry.path().string());
-                    } catch (const std::exception& e) {
-                        std::cerr << "Error extrayendo número del frame de: " << filename << std::endl;
+        withXyzFile(waterFile, [&](XyzParser& parser) {
+            {
+                Metrics::Timer timer(metrics, Stage::Read);
+                parser.beginWaterFrame();
+            }
+            while (true) {
+                {
+                    Metrics::Timer timer(metrics, Stage::Read);
+                    if (!parser.nextWaters(chunk, streamChunk, waterSelection)) {
+                        break;
                     }
                 }
+                distances.resize(chunk.size());
+                searchWaters(*work, chunk.x.data(), chunk.y.data(), chunk.z.data(), chunk.size(),
+                             distances.data());
+                binWaters(*work, distances, {chunk.Q4, chunk.Q6, chunk.W4, chunk.W6}, 0);
             }
+        });
+    } catch (const std::exception& e) {
+        work->failed = true;
+        std::cerr << "Error procesando frame " + std::to_string(frame.frameNumber) + ": " + e.what() + "\n";
+    }
+    finishFrame(*work);
+}
+
+void ProteinWaterAnalyzer::searchWaters(FrameWork& work, const double* wx, const double* wy,
+                                        const double* wz, size_t count, double* distances) {
+    Metrics::Timer timer(metrics, Stage::Search);
+    if (work.cells) {
+        work.cells->findMinDistances(wx, wy, wz, count, searchDistance, distances);
+    } else if (work.cellsFloat) {
+        work.cellsFloat->findMinDistances(wx, wy, wz, count, searchDistance, distances);
+    } else if (precision == Precision::Float) {
+        calculateMinDistances(work.atomX.data(), work.atomY.data(), work.atomZ.data(),
+                              work.atomX.size(), wx, wy, wz, count, work.box, distances);
+    } else {
+        const PositionsView& atoms = work.frame.protein;
+        calculateMinDistances(atoms.x.data(), atoms.y.data(), atoms.z.data(), atoms.size(),
+                              wx, wy, wz, count, work.box, distances);
+    }
+}
+
+void ProteinWaterAnalyzer::binWaters(FrameWork& work, std::span<const double> distances,
+                                     const std::array<std::span<const double>, 4>& parameters,
+                                     size_t offset) {
+    Metrics::Timer timer(metrics, Stage::Histogram);
+    const size_t count = distances.size();
+
+    // Las mismas distancias alimentan el histograma de cada parámetro;
+    // el bloque se acumula de una vez en el shard del worker que lo corre
+    for (size_t h = 0; h < histograms.size(); ++h) {
+        std::span<const double> column = parameters[parameterIndices[h] - 1].subspan(offset, count);
+        histograms[h].addDataPoints(distances, column, ThreadPool::workerIndex());
+        if (!jointHistograms.empty()) {
+            jointHistograms[h].addDataPoints(distances, column, ThreadPool::workerIndex());
+        }
+        // Los esquemas adicionales sólo cambian la búsqueda del bin
+        for (size_t b = h; b < binnedHistograms.size(); b += histograms.size()) {
+            binnedHistograms[b].addDataPoints(distances, column, ThreadPool::workerIndex());
+        }
+    }
+
+    // Sumas del bloque de aguas para los promedios del frame
+    if (blockAverages) {
+        BlockAverages::FrameBins partial = blockAverages->emptyFrame();
+        for (size_t h = 0; h < histograms.size(); ++h) {
+            std::span<const double> column = parameters[parameterIndices[h] - 1].subspan(offset, count);
+            blockAverages->accumulate(partial, h, distances, column);
+        }
+        std::lock_guard<std::mutex> lock(work.binsMutex);
+        for (size_t k = 0; k < partial.sum.size(); ++k) {
+            work.frameBins.sum[k] += partial.sum[k];
+            work.frameBins.count[k] += partial.count[k];
         }
-    } catch (const std::filesystem::filesystem_error& e) {
-        throw std::runtime_error("Error accediendo al directorio: " + std::string(e.what()));
     }
-    
-    // Ordenar por número de frame
-    std::sort(waterFiles.begin(), waterFiles.end(), 
-              [](const auto& a, const auto& b) { return a.first < b.first; });
-    
-    return waterFiles;
 }
 
-// Encontrar pares de archivos que coincidan
-std::vector<std::pair<int, std::pair<std::string, std::string>>> ProteinWaterAnalyzer::findFilePairs(const std::string& directory) {
-    auto proteinFiles = findProteinFiles(directory);
-    auto waterFiles = findWaterFiles(directory);
-    
-    std::vector<std::pair<int, std::pair<std::string, std::string>>> filePairs;
-    
-    // Crear mapas para búsqueda rápida
-    std::map<int, std::string> proteinMap(proteinFiles.begin(), proteinFiles.end());
-    std::map<int, std::string> waterMap(waterFiles.begin(), waterFiles.end());
-    
-    // Encontrar frames que tengan ambos archivos
-    for (const auto& [frame, proteinFile] : proteinMap) {
-        auto waterIt = waterMap.find(frame);
-        if (waterIt != waterMap.end()) {
-            filePairs.emplace_back(frame, std::make_pair(proteinFile, waterIt->second));
+void ProteinWaterAnalyzer::analyzeChunk(FrameWork& work, size_t begin, size_t end) {
+    try {
+        const size_t count = end - begin;
+        const PositionsView& waters = work.frame.waters;
+        const double* wx = waters.x.data();
+        const double* wy = waters.y.data();
+        const double* wz = waters.z.data();
+        std::vector<double> distances(count);
+        if (work.useVerlet) {
+            Metrics::Timer timer(metrics, Stage::Search);
+            verlet->findMinDistances(work.frame.protein, work.cells ? &*work.cells : nullptr,
+                                     wx, wy, wz, begin, end, searchDistance, distances.data());
         } else {
-            std::cerr << "Advertencia: No se encontró archivo de agua para el frame " << frame << std::endl;
+            searchWaters(work, wx + begin, wy + begin, wz + begin, count, distances.data());
         }
+        binWaters(work, distances, work.frame.parameters, begin);
+    } catch (const std::exception& e) {
+        work.failed = true;
+        std::cerr << "Error procesando frame " + std::to_string(work.frame.frameNumber) + ": " + e.what() + "\n";
     }
-    
-    // También verificar frames de agua sin proteína
-    for (const auto& [frame, waterFile] : waterMap) {
-        if (proteinMap.find(frame) == proteinMap.end()) {
-            std::cerr << "Advertencia: No se encontró archivo de proteína para el frame " << frame << std::endl;
+
+    if (--work.remaining == 0) {
+        finishFrame(work);
+    }
+}
+
+void ProteinWaterAnalyzer::finishFrame(FrameWork& work) {
+    if (!work.failed) {
+        if (blockAverages) {
+            blockAverages->addFrame(work.frame.sequence, work.frame.frameNumber, work.frameBins);
         }
+        reportFrameDone(work.frame.frameNumber);
+    }
+    if (work.release) {
+        work.release(!work.failed);
     }
-    
-    std::cout << "Encontrados " << filePairs.size() << " pares de archivos válidos" << std::endl;
-    return filePairs;
+}
+
+void ProteinWaterAnalyzer::reportFrameDone(int frameNumber) {
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        doneFrames.insert(frameNumber);
+    }
+    // El avance lo muestra el ProgressReporter de runPipeline
+    processedFrames++;
 }
 
 void ProteinWaterAnalyzer::processFrame(int frameNumber, const std::string& proteinFile, 
-                     const std::string& waterFile, int parameterIndex) {
-    auto future = pool.enqueue([this, frameNumber, proteinFile, waterFile, parameterIndex]() {
+                     const std::string& waterFile) {
+    auto future = pool.enqueue([this, frameNumber, proteinFile, waterFile]() {
         try {
-            // Leer datos
-            FrameData frame = readProteinFile(proteinFile, frameNumber);
-            readWaterFile(waterFile, frame);
-            
-            // Procesar cada molécula de agua
-            for (const auto& water : frame.waterMolecules) {
-                if (water.element == "O") { // Solo átomos de oxígeno
-                    double minDist = calculateMinDistance(water, frame.proteinAtoms, 
-                                                        frame.Lx, frame.Ly, frame.Lz);
-                    
-                    double parameter;
-                    switch (parameterIndex) {
-                        case 1: parameter = water.Q4; break;
-                        case 2: parameter = water.Q6; break;
-                        case 3: parameter = water.W4; break;
-                        case 4: parameter = water.W6; break;
-                        default: parameter = water.Q6; break;
-                    }
-                    
-                    histogram.addDataPoint(minDist, parameter);
-                }
+            // Leer datos; el frame vive hasta que termine su último bloque
+            auto frame = std::make_shared<FrameData>(frameNumber);
+            frame->sequence = frameNumber;
+            readProteinFile(proteinFile, *frame, proteinSelection);
+            if (streamWaters) {
+                analyzeStreamedFrame(*frame, waterFile, [](bool) {});
+                return;
             }
-            
-            processedFrames++;
-            std::cout << "Procesado frame " << frameNumber 
-                     << " (" << processedFrames << "/" << totalFrames << ")" << std::endl;
+            readWaterFile(waterFile, *frame, waterSelection);
+            analyzeFrame(frame->view(), [frame](bool) {});
                     
         } catch (const std::exception& e) {
             std::cerr << "Error procesando frame " << frameNumber << ": " << e.what() << std::endl;
@@ -230,7 +385,8 @@ void ProteinWaterAnalyzer::processFrame(int frameNumber, const std::string& prot
 }
 
 // Procesar desde directorio
-void ProteinWaterAnalyzer::processDirectory(const std::string& directory, int parameterIndex) {
+void ProteinWaterAnalyzer::processDirectory(const std::string& directory,
+                                            const std::string& cacheFile) {
     auto filePairs = findFilePairs(directory);
     totalFrames = filePairs.size();
     processedFrames = 0;
@@ -239,24 +395,809 @@ void ProteinWaterAnalyzer::processDirectory(const std::string& directory, int pa
         std::cerr << "Error: No se encontraron pares de archivos válidos en el directorio: " << directory << std::endl;
         return;
     }
+
+    // Al reanudar sólo quedan los frames nuevos; el caché igual se valida
+    // contra todos los archivos
+    // La posición de cada frame entre todos los pares define su bloque
+    std::vector<bool> selected(filePairs.size(), false);
+    std::vector<size_t> pending;
+    for (size_t i : selectFrames(filePairs)) {
+        selected[i] = true;
+        if (!isFrameDone(filePairs[i].first)) {
+            pending.push_back(i);
+        }
+    }
+    auto positionOf = [&filePairs](int frameNumber) {
+        auto it = std::lower_bound(filePairs.begin(), filePairs.end(), frameNumber,
+                                   [](const auto& pair, int number) { return pair.first < number; });
+        return static_cast<size_t>(it - filePairs.begin());
+    };
+    const size_t numSelected = std::count(selected.begin(), selected.end(), true);
+    if (numSelected < filePairs.size()) {
+        std::cout << "Rango de frames: " << numSelected << " de " << filePairs.size() << " pares" << std::endl;
+    }
+    if (pending.size() < numSelected) {
+        std::cout << "Reanudando: " << numSelected - pending.size() << " frames ya procesados, "
+                  << pending.size() << " nuevos" << std::endl;
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    std::vector<std::string> sources;
+    sources.reserve(2 * filePairs.size());
+    for (const auto& [frameNumber, files] : filePairs) {
+        sources.push_back(files.first);
+        sources.push_back(files.second);
+    }
+
+    if (!cacheFile.empty() && FrameCache::isUpToDate(cacheFile, directory, sources, listedTime)) {
+        cache = std::make_unique<FrameCache>(cacheFile);
+    }
+    std::vector<size_t> cacheFrames;
+    for (size_t i = 0; cache && i < cache->size(); ++i) {
+        const int frameNumber = cache->frameNumber(i);
+        const size_t position = positionOf(frameNumber);
+        if (position < filePairs.size() && filePairs[position].first == frameNumber &&
+            selected[position] && !isFrameDone(frameNumber)) {
+            cacheFrames.push_back(i);
+        }
+    }
+    // Un frame que llegó al directorio con una fecha vieja (mv) no está en
+    // el caché: se lee todo desde el directorio
+    if (cache && cacheFrames.size() < pending.size()) {
+        std::cerr << "Advertencia: El caché no tiene todos los frames, se lee el directorio" << std::endl;
+        cache.reset();
+    }
+    if (cache) {
+        totalFrames = cacheFrames.size();
+        std::cout << "Procesando " << totalFrames << " frames desde el caché: " << cacheFile << std::endl;
+
+        runPipeline([this, &cacheFrames, &positionOf](size_t index, FrameData& frame) {
+            if (index >= cacheFrames.size()) {
+                return false;
+            }
+            Metrics::Timer timer(metrics, Stage::Read);
+            frame.frameNumber = cache->frameNumber(cacheFrames[index]);
+            metrics.addBytesRead(cache->readFrame(cacheFrames[index], frame, proteinSelection, waterSelection));
+            frame.sequence = positionOf(frame.frameNumber);
+            return true;
+        }, numReaders, true);
+        return;
+    }
     
+    totalFrames = pending.size();
     std::cout << "Procesando " << totalFrames << " frames desde el directorio: " << directory << std::endl;
-    
-    for (const auto& [frameNumber, files] : filePairs) {
-        processFrame(frameNumber, files.first, files.second, parameterIndex);
+
+    // Con streamWaters los lectores sólo cargan la proteína y el worker
+    // lee las aguas del par por tandas (la posición del frame es sequence)
+    WaterSource waterSource;
+    if (streamWaters) {
+        waterSource = [&filePairs](const FrameData& frame) -> const std::string& {
+            return filePairs[frame.sequence].second.second;
+        };
+    }
+    runPipeline([this, &pending, &filePairs](size_t index, FrameData& frame) {
+        if (index >= pending.size()) {
+            return false;
+        }
+        const auto& [frameNumber, files] = filePairs[pending[index]];
+        frame.frameNumber = frameNumber;
+        frame.sequence = pending[index];
+        readProteinFile(files.first, frame, proteinSelection);
+        if (streamWaters) {
+            frame.waterMolecules.resize(0);
+        } else {
+            readWaterFile(files.second, frame, waterSelection);
+        }
+        return true;
+    }, numReaders, true, waterSource);
+}
+
+void ProteinWaterAnalyzer::processTrajectory(const std::string& proteinFile,
+                                             const std::string& waterFile) {
+    TrajectoryReader proteinReader(proteinFile, TrajectoryReader::Kind::Protein, proteinSelection);
+    TrajectoryReader waterReader(waterFile, TrajectoryReader::Kind::Water, waterSelection);
+    if (frameRange.numShards > 1) {
+        throw std::runtime_error("-shard necesita un directorio de frames: en una trayectoria "
+                                 "la cantidad de frames no se conoce de antemano (usar -begin/-end)");
+    }
+    totalFrames = 0;  // Desconocido hasta terminar de leer
+    processedFrames = 0;
+
+    std::cout << "Procesando trayectorias: " << proteinFile << " y " << waterFile << std::endl;
+
+    // Un solo lector: los archivos se recorren en secuencia. Al reanudar,
+    // los frames ya procesados se leen (hay que atravesarlos) pero no se
+    // entregan al pool. Lo mismo los que quedan fuera de -begin/-end/-stride.
+    size_t position = 0;
+    size_t inRange = 0;
+    runPipeline([&](size_t, FrameData& frame) {
+        Metrics::Timer timer(metrics, Stage::Read);
+        while (true) {
+            bool hasProtein = proteinReader.readFrame(frame);
+            bool hasWater = waterReader.readFrame(frame);
+            if (!hasProtein || !hasWater) {
+                if (hasProtein) {
+                    std::cerr << "Advertencia: La trayectoria de agua termina antes que la de proteína" << std::endl;
+                } else if (hasWater) {
+                    std::cerr << "Advertencia: La trayectoria de proteína termina antes que la de agua" << std::endl;
+                }
+                return false;
+            }
+
+            auto proteinNumber = proteinReader.commentFrameNumber();
+            auto waterNumber = waterReader.commentFrameNumber();
+            frame.frameNumber = proteinNumber ? *proteinNumber
+                                              : (waterNumber ? *waterNumber : static_cast<int>(position));
+            frame.sequence = position++;
+            if (proteinNumber && waterNumber && *proteinNumber != *waterNumber) {
+                throw std::runtime_error("Frames desalineados: proteína " + std::to_string(*proteinNumber) +
+                                         ", agua " + std::to_string(*waterNumber));
+            }
+            if (frame.frameNumber < frameRange.begin || frame.frameNumber >= frameRange.end ||
+                inRange++ % frameRange.stride != 0) {
+                continue;
+            }
+            if (!isFrameDone(frame.frameNumber)) {
+                return true;
+            }
+        }
+    }, 1, false);
+    metrics.addBytesRead(proteinReader.bytesRead() + waterReader.bytesRead());
+}
+
+void ProteinWaterAnalyzer::runPipeline(const FrameReader& read, size_t readers, bool skipErrors,
+                                       const WaterSource& waterSource) {
+    // Anillo de buffers reutilizables: limita los frames en memoria y
+    // conserva la capacidad de sus arreglos entre frames
+    const size_t slots = std::max<size_t>(framesInFlight, 1);
+    std::vector<std::unique_ptr<FrameData>> frames;
+    BoundedQueue<FrameData*> freeFrames(slots);
+    BoundedQueue<FrameData*> readyFrames(slots);
+    for (size_t i = 0; i < slots; ++i) {
+        frames.push_back(std::make_unique<FrameData>(0));
+        freeFrames.push(frames.back().get());
+    }
+
+    // La lista de Verlet necesita los frames en orden y de a uno
+    if (verlet) {
+        readers = 1;
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::atomic<size_t> activeReaders(readers);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    // Lectores: toman un buffer libre (esperan si no hay), leen el próximo
+    // frame y lo pasan a la cola de frames listos
+    auto readerLoop = [&]() {
+        FrameData* frame;
+        while (!failed && freeFrames.pop(frame)) {
+            size_t index = nextIndex++;
+            try {
+                if (!read(index, *frame)) {
+                    freeFrames.push(frame);
+                    break;
+                }
+                readyFrames.push(frame);
+            } catch (const std::exception& e) {
+                freeFrames.push(frame);
+                if (!skipErrors) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    error = std::current_exception();
+                    failed = true;
+                    break;
+                }
+                // Un solo mensaje para no mezclarse con los de otros lectores
+                std::cerr << "Error procesando frame " + std::to_string(frame->frameNumber) + ": " + e.what() + "\n";
+            }
+        }
+        if (--activeReaders == 0) {
+            readyFrames.close();
+        }
+    };
+
+    ProgressReporter progress(processedFrames, totalFrames, progressInterval);
+
+    std::vector<std::thread> readerThreads;
+    for (size_t r = 0; r < readers; ++r) {
+        readerThreads.emplace_back(readerLoop);
+    }
+
+    // Los frames listos se entregan al pool; al terminar cada uno, su
+    // buffer vuelve a quedar libre para los lectores
+    FrameData* frame;
+    while (readyFrames.pop(frame)) {
+        pool.enqueue([this, frame, &freeFrames, &waterSource]() {
+            try {
+                auto release = [frame, &freeFrames](bool) { freeFrames.push(frame); };
+                if (waterSource) {
+                    analyzeStreamedFrame(*frame, waterSource(*frame), release);
+                } else {
+                    analyzeFrame(frame->view(), release);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error procesando frame " << frame->frameNumber << ": " << e.what() << std::endl;
+                freeFrames.push(frame);
+            }
+        });
+        if (verlet) {
+            pool.wait();
+        }
+        checkpointIfDue();
+    }
+
+    for (auto& thread : readerThreads) {
+        thread.join();
+    }
+
+    // Las tareas usan los buffers locales
+    pool.wait();
+
+    if (error) {
+        std::rethrow_exception(error);
     }
 }
 
+void ProteinWaterAnalyzer::setPipeline(size_t readers, size_t inFlight) {
+    numReaders = std::max<size_t>(readers, 1);
+    framesInFlight = std::max<size_t>(inFlight, 1);
+}
 
+void ProteinWaterAnalyzer::setManifest(const std::string& file) {
+    manifestFile = file;
+}
+
+void ProteinWaterAnalyzer::setFrameRange(const FrameRange& range) {
+    if (range.stride < 1 || range.numShards < 1 || range.shard >= range.numShards) {
+        throw std::runtime_error("Rango de frames inválido");
+    }
+    frameRange = range;
+}
+
+std::vector<size_t> ProteinWaterAnalyzer::selectFrames(
+    const std::vector<std::pair<int, std::pair<std::string, std::string>>>& filePairs) const {
+    std::vector<size_t> inRange;
+    for (size_t i = 0; i < filePairs.size(); ++i) {
+        const int frameNumber = filePairs[i].first;
+        if (frameNumber >= frameRange.begin && frameNumber < frameRange.end) {
+            inRange.push_back(i);
+        }
+    }
+    std::vector<size_t> strided;
+    for (size_t k = 0; k < inRange.size(); k += frameRange.stride) {
+        strided.push_back(inRange[k]);
+    }
+
+    // Porciones contiguas: cada shard conserva frames consecutivos (bloques,
+    // lista de Verlet) y los tamaños difieren a lo sumo en uno
+    const size_t first = frameRange.shard * strided.size() / frameRange.numShards;
+    const size_t last = (frameRange.shard + 1) * strided.size() / frameRange.numShards;
+    return std::vector<size_t>(strided.begin() + first, strided.begin() + last);
+}
+
+void ProteinWaterAnalyzer::setProgressInterval(double seconds) {
+    progressInterval = std::max(seconds, 0.0);
+}
+
+void ProteinWaterAnalyzer::writeMetrics(const std::string& filename) {
+    metrics.report(filename, pool.size(), static_cast<size_t>(processedFrames));
+}
+
+void ProteinWaterAnalyzer::enableJointHistogram(int parameterBins,
+                                                std::optional<std::pair<double, double>> range) {
+    jointHistograms.clear();
+    for (int parameterIndex : parameterIndices) {
+        auto [low, high] = range ? *range : bopRange(parameterIndex);
+        jointHistograms.emplace_back(minDistance, maxDistance, distanceBins,
+                                     low, high, parameterBins, pool.size());
+    }
+}
+
+void ProteinWaterAnalyzer::enableBlockAverages(size_t blockSize, bool series) {
+    blockAverages = std::make_unique<BlockAverages>(minDistance, maxDistance, distanceBins,
+                                                    parameterIndices.size(), blockSize, series);
+}
+
+void ProteinWaterAnalyzer::setSelection(const ElementMask& protein, const ElementMask& water) {
+    proteinSelection = protein;
+    waterSelection = water;
+}
+
+void ProteinWaterAnalyzer::setSkin(double skin) {
+    if (skin > 0 && precision != Precision::Double) {
+        throw std::runtime_error("La lista de Verlet requiere precisión double");
+    }
+    if (skin > 0 && streamWaters) {
+        throw std::runtime_error("La lista de Verlet necesita las aguas de todo el frame (sin -stream)");
+    }
+    verlet = skin > 0 ? std::make_unique<VerletList>(skin) : nullptr;
+}
+
+void ProteinWaterAnalyzer::addBinning(const Binning& binning) {
+    binnings.push_back(binning);
+    for (size_t h = 0; h < parameterIndices.size(); ++h) {
+        binnedHistograms.emplace_back(binning, pool.size());
+    }
+    // La búsqueda tiene que confirmar las distancias de todos los esquemas
+    searchDistance = std::max(searchDistance, binning.upper());
+}
+
+size_t ProteinWaterAnalyzer::setAffinity(const std::string& spec) {
+    if (spec.empty() || spec == "none") {
+        return 0;
+    }
+    Topology topology;
+    const std::vector<int> cpus = topology.placement(spec, pool.size());
+    pool.pin(cpus);
+
+    nodeWorkers.assign(topology.numNodes(), {});
+    for (size_t w = 0; w < cpus.size(); ++w) {
+        nodeWorkers[topology.nodeOf(cpus[w])].push_back(w);
+    }
+    std::erase_if(nodeWorkers, [](const auto& group) { return group.empty(); });
+    return nodeWorkers.size();
+}
+
+void ProteinWaterAnalyzer::setStreamWaters(bool stream) {
+    if (stream && verlet) {
+        throw std::runtime_error("La lista de Verlet necesita las aguas de todo el frame (sin -stream)");
+    }
+    streamWaters = stream;
+}
+
+void ProteinWaterAnalyzer::setPrecision(Precision p) {
+    if (p != Precision::Double && verlet) {
+        throw std::runtime_error("La lista de Verlet requiere precisión double");
+    }
+    precision = p;
+}
+
+void ProteinWaterAnalyzer::convertDirectory(const std::string& directory, const std::string& cacheFile,
+                                            bool singlePrecision) {
+    auto filePairs = findFilePairs(directory);
+    if (filePairs.empty()) {
+        throw std::runtime_error("No se encontraron pares de archivos válidos en el directorio: " + directory);
+    }
+
+    FrameCacheWriter writer(cacheFile, singlePrecision);
+
+    // Los frames se leen en paralelo por lotes y se escriben en orden
+    const size_t batchSize = 2 * pool.size();
+    for (size_t start = 0; start < filePairs.size(); start += batchSize) {
+        const size_t stop = std::min(start + batchSize, filePairs.size());
+        std::vector<std::future<FrameData>> pending;
+        for (size_t i = start; i < stop; ++i) {
+            const auto& [frameNumber, files] = filePairs[i];
+            pending.push_back(pool.enqueue([this, frameNumber, &files]() {
+                // El caché guarda todos los átomos: la selección se aplica al leerlo
+                FrameData frame(frameNumber);
+                readProteinFile(files.first, frame, ElementMask::all());
+                readWaterFile(files.second, frame, ElementMask::all());
+                return frame;
+            }));
+        }
+        for (auto& frame : pending) {
+            writer.addFrame(frame.get());
+        }
+        std::cout << "Convertidos " << stop << "/" << filePairs.size() << " frames" << std::endl;
+    }
+
+    writer.finish();
+    std::cout << "Caché escrito en: " << cacheFile << std::endl;
+}
+
+
+
+void ProteinWaterAnalyzer::mergeHistograms() {
+    // Con los workers en varios nodos NUMA, cada nodo pliega sus shards en
+    // uno de sus workers y sólo ese shard cruza hasta los totales. Los
+    // conteos del histograma conjunto son de 32 bits por shard y no se
+    // pliegan.
+    if (nodeWorkers.size() > 1) {
+        std::vector<size_t> leaders;
+        for (const auto& group : nodeWorkers) {
+            leaders.push_back(group.front());
+            pool.enqueueOn(group.front(), [this, &group]() {
+                for (auto& histogram : histograms) {
+                    histogram.foldShards(group);
+                }
+                for (auto& histogram : binnedHistograms) {
+                    histogram.foldShards(group);
+                }
+            });
+        }
+        pool.wait();
+        for (auto& histogram : histograms) {
+            histogram.mergeShards(leaders);
+        }
+        for (auto& histogram : binnedHistograms) {
+            histogram.mergeShards(leaders);
+        }
+    } else {
+        for (auto& histogram : histograms) {
+            histogram.mergeShards();
+        }
+        for (auto& histogram : binnedHistograms) {
+            histogram.mergeShards();
+        }
+    }
+    for (auto& histogram : jointHistograms) {
+        histogram.mergeShards();
+    }
+}
 
 void ProteinWaterAnalyzer::wait() {
     // Delegar al thread pool
     pool.wait();
+
+    // Con todos los workers detenidos se combinan los acumuladores por hilo
+    mergeHistograms();
+
+    if (!checkpointFile.empty()) {
+        writeCheckpoint();
+    }
+}
+
+bool ProteinWaterAnalyzer::isFrameDone(int frameNumber) {
+    std::lock_guard<std::mutex> lock(doneMutex);
+    return doneFrames.count(frameNumber) > 0;
+}
+
+void ProteinWaterAnalyzer::setCheckpoint(const std::string& file, size_t interval) {
+    checkpointFile = file;
+    checkpointInterval = interval;
+}
+
+void ProteinWaterAnalyzer::checkpointIfDue() {
+    if (checkpointFile.empty() || checkpointInterval == 0 ||
+        static_cast<size_t>(processedFrames - checkpointedFrames) < checkpointInterval) {
+        return;
+    }
+    pool.wait();
+    mergeHistograms();
+    writeCheckpoint();
 }
-void ProteinWaterAnalyzer::saveHistogram(const std::string& filename) {
-    histogram.saveToFile(filename);
+
+void ProteinWaterAnalyzer::writeCheckpoint() {
+    writeState(checkpointFile);
+    checkpointedFrames = processedFrames;
+}
+
+void ProteinWaterAnalyzer::writeState(const std::string& filename) {
+    Metrics::Timer timer(metrics, Stage::Output);
+    // Se escribe a un temporal y se renombra: un corte a mitad de escritura
+    // deja el checkpoint anterior intacto
+    const std::string tempFile = filename + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("No se pudo crear el archivo: " + tempFile);
+    }
+    writeState(out);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Error escribiendo el checkpoint: " + tempFile);
+    }
+    std::filesystem::rename(tempFile, filename);
+}
+
+void ProteinWaterAnalyzer::writeState(std::ostream& out) {
+    std::vector<int32_t> frames;
+    {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        frames.assign(doneFrames.begin(), doneFrames.end());
+    }
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+    header.version = checkpointVersion;
+    header.numParameters = parameterIndices.size();
+    header.numJoint = jointHistograms.size();
+    header.blockSize = blockAverages ? blockAverages->getBlockSize() : 0;
+    header.numFrames = frames.size();
+    header.minDistance = minDistance;
+    header.maxDistance = maxDistance;
+    header.distanceBins = distanceBins;
+    header.jointBins = jointHistograms.empty() ? 0 : jointHistograms[0].getParameterBins();
+    std::vector<int32_t> parameters(parameterIndices.begin(), parameterIndices.end());
+    std::vector<double> jointRanges;
+    for (const auto& histogram : jointHistograms) {
+        auto [low, high] = histogram.getParameterRange();
+        jointRanges.push_back(low);
+        jointRanges.push_back(high);
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(parameters.data()), parameters.size() * sizeof(int32_t));
+    out.write(reinterpret_cast<const char*>(jointRanges.data()), jointRanges.size() * sizeof(double));
+    const uint32_t numBinnings = binnings.size();
+    out.write(reinterpret_cast<const char*>(&numBinnings), sizeof(numBinnings));
+    for (const auto& binning : binnings) {
+        binning.save(out);
+    }
+    out.write(reinterpret_cast<const char*>(frames.data()), frames.size() * sizeof(int32_t));
+    for (const auto& histogram : histograms) {
+        histogram.save(out);
+    }
+    for (const auto& histogram : jointHistograms) {
+        histogram.save(out);
+    }
+    if (header.blockSize > 0) {
+        blockAverages->save(out);
+    }
+    for (const auto& histogram : binnedHistograms) {
+        histogram.save(out);
+    }
+}
+
+size_t ProteinWaterAnalyzer::loadState(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+    }
+    return loadState(in, filename);
+}
+
+size_t ProteinWaterAnalyzer::loadState(std::istream& in, const std::string& filename) {
+    std::vector<int32_t> parameters;
+    std::vector<double> jointRanges;
+    std::vector<Binning> savedBinnings;
+    CheckpointHeader header = readCheckpointHeader(in, filename, parameters, jointRanges, savedBinnings);
+    if (!std::equal(parameters.begin(), parameters.end(),
+                    parameterIndices.begin(), parameterIndices.end()) ||
+        header.numJoint != jointHistograms.size() ||
+        header.blockSize != (blockAverages ? blockAverages->getBlockSize() : 0) ||
+        savedBinnings != binnings) {
+        throw std::runtime_error("El checkpoint se hizo con otros parámetros de orden, -2d, -block o -binning: " +
+                                 filename);
+    }
+
+    std::vector<int32_t> frames(header.numFrames);
+    in.read(reinterpret_cast<char*>(frames.data()), frames.size() * sizeof(int32_t));
+    if (!in) {
+        throw std::runtime_error("Checkpoint truncado: " + filename);
+    }
+
+    // Un frame contado dos veces sesgaría los promedios
+    std::lock_guard<std::mutex> lock(doneMutex);
+    for (int32_t frame : frames) {
+        if (doneFrames.count(frame) > 0) {
+            throw std::runtime_error("El frame " + std::to_string(frame) + " de " + filename +
+                                     " ya estaba incluido en otro resultado");
+        }
+    }
+
+    for (auto& histogram : histograms) {
+        histogram.load(in);
+    }
+    for (auto& histogram : jointHistograms) {
+        histogram.load(in);
+    }
+    if (header.blockSize > 0) {
+        blockAverages->load(in);
+    }
+    for (auto& histogram : binnedHistograms) {
+        histogram.load(in);
+    }
+    doneFrames.insert(frames.begin(), frames.end());
+    return frames.size();
+}
+
+size_t ProteinWaterAnalyzer::resume() {
+    if (!std::filesystem::exists(checkpointFile)) {
+        return 0;
+    }
+    return loadState(checkpointFile);
+}
+
+void ProteinWaterAnalyzer::writePartial(const std::string& filename) {
+    writeState(filename);
+}
+
+size_t ProteinWaterAnalyzer::mergePartial(const std::string& filename) {
+    size_t frames = loadState(filename);
+    processedFrames += static_cast<int>(frames);
+    return frames;
+}
+
+void ProteinWaterAnalyzer::accumulate(const FrameView& frame) {
+    const size_t numAtoms = frame.protein.size();
+    const size_t numWaters = frame.waters.size();
+    if (frame.protein.y.size() != numAtoms || frame.protein.z.size() != numAtoms ||
+        frame.waters.y.size() != numWaters || frame.waters.z.size() != numWaters) {
+        throw std::invalid_argument("Frame " + std::to_string(frame.frameNumber) +
+                                    ": las coordenadas x, y, z tienen distinto tamaño");
+    }
+    for (int parameterIndex : parameterIndices) {
+        if (frame.parameters[parameterIndex - 1].size() != numWaters) {
+            throw std::invalid_argument("Frame " + std::to_string(frame.frameNumber) + ": la columna " +
+                                        bopName(parameterIndex) + " no tiene un valor por agua");
+        }
+    }
+
+    // El frame se arma en un worker (cada worker acumula en su shard) y
+    // la llamada espera a que el último bloque lo suelte
+    std::promise<bool> released;
+    std::future<bool> done = released.get_future();
+    pool.enqueue([this, &frame, &released]() {
+        analyzeFrame(frame, [&released](bool ok) { released.set_value(ok); });
+    }).get();
+    if (!done.get()) {
+        throw std::runtime_error("No se pudo procesar el frame " + std::to_string(frame.frameNumber));
+    }
+}
+
+size_t ProteinWaterAnalyzer::merge(ProteinWaterAnalyzer& other) {
+    other.pool.wait();
+    other.mergeHistograms();
+    std::stringstream state;
+    other.writeState(state);
+    size_t frames = loadState(state, "el analizador combinado");
+    processedFrames += static_cast<int>(frames);
+    return frames;
+}
+
+std::vector<HistogramResult> ProteinWaterAnalyzer::finalize() {
+    wait();
+    std::vector<HistogramResult> results;
+    for (size_t h = 0; h < histograms.size(); ++h) {
+        const Histogram1D& histogram = histograms[h];
+        HistogramResult result{parameterIndices[h], {}, {}, {}, histogram.getCounts()};
+        for (int i = 0; i < histogram.getNumBins(); ++i) {
+            result.distance.push_back(histogram.getBinCenter(i));
+        }
+        std::tie(result.average, result.stddev) = histogram.getAverageValues();
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::unique_ptr<ProteinWaterAnalyzer> ProteinWaterAnalyzer::fromPartial(const std::string& filename,
+                                                                        size_t numThreads) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("No se pudo abrir el archivo: " + filename);
+    }
+    std::vector<int32_t> parameters;
+    std::vector<double> jointRanges;
+    std::vector<Binning> binnings;
+    CheckpointHeader header = readCheckpointHeader(in, filename, parameters, jointRanges, binnings);
+
+    auto analyzer = std::make_unique<ProteinWaterAnalyzer>(
+        numThreads, header.minDistance, header.maxDistance, header.distanceBins,
+        std::vector<int>(parameters.begin(), parameters.end()));
+    if (header.numJoint > 0) {
+        analyzer->jointHistograms.clear();
+        for (size_t h = 0; h < header.numJoint; ++h) {
+            analyzer->jointHistograms.emplace_back(header.minDistance, header.maxDistance,
+                                                   header.distanceBins, jointRanges[2 * h],
+                                                   jointRanges[2 * h + 1], header.jointBins,
+                                                   analyzer->pool.size());
+        }
+    }
+    if (header.blockSize > 0) {
+        analyzer->enableBlockAverages(header.blockSize, false);
+    }
+    for (const auto& binning : binnings) {
+        analyzer->addBinning(binning);
+    }
+    return analyzer;
+}
+
+void ProteinWaterAnalyzer::saveHistogram(const std::string& filename, bool combined) {
+    Metrics::Timer timer(metrics, Stage::Output);
+    // histograma.dat -> histograma-2d-Q6.dat, histograma-blocks-Q6.dat, ...
+    std::filesystem::path path(filename);
+    auto outputFor = [&path](const std::string& kind, int parameterIndex) {
+        std::filesystem::path output = path;
+        output.replace_filename(path.stem().string() + "-" + kind + "-" + bopName(parameterIndex) +
+                                path.extension().string());
+        return output.string();
+    };
+    for (size_t h = 0; h < jointHistograms.size(); ++h) {
+        std::string output = outputFor("2d", parameterIndices[h]);
+        std::cout << "  P(" << bopName(parameterIndices[h]) << " | r): " << output << std::endl;
+        jointHistograms[h].saveToFile(output, bopName(parameterIndices[h]));
+    }
+    for (size_t h = 0; blockAverages && h < parameterIndices.size(); ++h) {
+        if (blockAverages->getBlockSize() > 0) {
+            std::string output = outputFor("blocks", parameterIndices[h]);
+            std::cout << "  Bloques " << bopName(parameterIndices[h]) << ": " << output << std::endl;
+            blockAverages->saveBlocks(output, h, bopName(parameterIndices[h]));
+        }
+        if (blockAverages->hasSeries()) {
+            std::string output = outputFor("series", parameterIndices[h]);
+            std::cout << "  Serie " << bopName(parameterIndices[h]) << ": " << output << std::endl;
+            blockAverages->saveSeries(output, h, bopName(parameterIndices[h]));
+        }
+    }
+
+    for (size_t b = 0; b < binnings.size(); ++b) {
+        std::filesystem::path output = path;
+        output.replace_filename(path.stem().string() + "-binning" + std::to_string(b + 1) +
+                                path.extension().string());
+        std::cout << "  Bins " << binnings[b].describe() << ": " << output.string() << std::endl;
+        writeHistograms(output.string(),
+                        std::span<const Histogram1D>(binnedHistograms).subspan(b * histograms.size(),
+                                                                               histograms.size()),
+                        combined);
+    }
+    writeHistograms(filename, histograms, combined);
+}
+
+void ProteinWaterAnalyzer::writeHistograms(const std::string& filename,
+                                           std::span<const Histogram1D> set, bool combined) {
+    std::filesystem::path path(filename);
+    if (set.size() == 1) {
+        set[0].saveToFile(filename);
+        return;
+    }
+
+    if (!combined) {
+        // histograma.dat -> histograma-Q4.dat, histograma-Q6.dat, ...
+        for (size_t h = 0; h < set.size(); ++h) {
+            std::filesystem::path output = path;
+            output.replace_filename(path.stem().string() + "-" + bopName(parameterIndices[h]) +
+                                    path.extension().string());
+            std::cout << "  " << bopName(parameterIndices[h]) << ": " << output.string() << std::endl;
+            set[h].saveToFile(output.string());
+        }
+        return;
+    }
+
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error al abrir el archivo: " << filename << std::endl;
+        return;
+    }
+
+    // Escribir encabezado: todos los parámetros comparten distancias y conteos
+    file << "# r";
+    for (int parameterIndex : parameterIndices) {
+        file << " avg_" << bopName(parameterIndex) << " std_" << bopName(parameterIndex);
+    }
+    const Histogram1D& reference = set[0];
+    const Binning& binning = reference.getBinning();
+    file << (binning.isUniform() ? " count\n" : " count r_low r_high\n");
+
+    std::vector<std::pair<std::vector<double>, std::vector<double>>> values;
+    for (const auto& histogram : set) {
+        values.push_back(histogram.getAverageValues());
+    }
+
+    for (int i = 0; i < reference.getNumBins(); ++i) {
+        file << std::fixed << std::setprecision(binning.isUniform() ? 3 : 6) << reference.getBinCenter(i)
+             << std::setprecision(6);
+        for (const auto& [averages, stdDevs] : values) {
+            file << " " << averages[i] << " " << stdDevs[i];
+        }
+        file << " " << reference.getCounts()[i];
+        if (!binning.isUniform()) {
+            file << " " << binning.lowerEdge(i) << " " << binning.upperEdge(i);
+        }
+        file << "\n";
+    }
 }
 
 void ProteinWaterAnalyzer::printStatistics() {
-    histogram.printStatistics();
+    // Los conteos son los mismos para todos los parámetros
+    histograms[0].printStatistics();
+    for (size_t b = 0; b < binnings.size(); ++b) {
+        std::cout << "Esquema de bins " << b + 1 << ": " << binnings[b].describe() << std::endl;
+    }
+
+    if (verlet) {
+        const size_t reused = verlet->getReusedWaters();
+        const size_t total = reused + verlet->getSearchedWaters();
+        std::cout << "Lista de Verlet (piel " << verlet->getSkin() << " Å): "
+                  << reused << "/" << total << " aguas resueltas sin búsqueda completa";
+        if (total > 0) {
+            std::cout << " (" << std::fixed << std::setprecision(1)
+                      << 100.0 * reused / total << "%)";
+        }
+        std::cout << std::endl;
+    }
 }
@@ -1,40 +1,140 @@
 #include "ThreadPool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
 
-ThreadPool::ThreadPool(size_t numThreads) : stop(false), activeTasks(0) {
+thread_local int ThreadPool::currentWorker = -1;
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : nextQueue(0), queuedTasks(0), pendingTasks(0), stop(false) {
+    // Sin colas, push dividiría por cero al repartir en round-robin
+    if (numThreads == 0) {
+        throw std::invalid_argument("El thread pool necesita al menos un hilo");
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
     for (size_t i = 0; i < numThreads; ++i) {
-        workers.emplace_back([this] {
-            while (true) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(this->queueMutex);
-                    this->condition.wait(lock, [this] {
-                        return this->stop.load(std::memory_order_relaxed) || !this->tasks.empty();
-                    });
-                    if (this->stop.load(std::memory_order_relaxed) && this->tasks.empty())
-                        return;
-                    task = std::move(this->tasks.front());
-                    this->tasks.pop();
-                }
-                // Ejecutar la tarea (esta aumentará/disminuirá activeTasks)
-                task();
-            }
+        workers.emplace_back([this, i] {
+            currentWorker = static_cast<int>(i);
+            workerLoop(i);
         });
     }
 }
 
+void ThreadPool::push(std::function<void()> task, int owner) {
+    // Desde un worker, a su propia cola; desde fuera, en round-robin
+    size_t target = owner >= 0 ? static_cast<size_t>(owner)
+                    : currentWorker >= 0 && static_cast<size_t>(currentWorker) < queues.size()
+                        ? static_cast<size_t>(currentWorker)
+                        : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    // Los contadores suben antes de publicar la tarea para que nunca
+    // queden por debajo de las tareas visibles en las colas
+    pendingTasks.fetch_add(1, std::memory_order_relaxed);
+    queuedTasks.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        (owner >= 0 ? queues[target]->owned : queues[target]->tasks).push_back(std::move(task));
+    }
+
+    // Tomar sleepMutex evita perder la notificación si un worker está
+    // justo por dormirse. Una tarea propia sólo la puede tomar su worker,
+    // así que se despierta a todos para no despertar sólo a otro.
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    if (owner >= 0) {
+        wakeUp.notify_all();
+    } else {
+        wakeUp.notify_one();
+    }
+}
+
+bool ThreadPool::popLocal(size_t worker, std::function<void()>& task) {
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.owned.empty()) {
+        task = std::move(queue.owned.front());
+        queue.owned.pop_front();
+        return true;
+    }
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, std::function<void()>& task) {
+    for (size_t k = 1; k < queues.size(); ++k) {
+        WorkerQueue& queue = *queues[(thief + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::taskFinished() {
+    if (pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        { std::lock_guard<std::mutex> lock(doneMutex); }
+        allDone.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    std::function<void()> task;
+    while (true) {
+        if (popLocal(worker, task) || steal(worker, task)) {
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            taskFinished();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] {
+            return stop.load(std::memory_order_relaxed) ||
+                   queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (stop.load(std::memory_order_relaxed) &&
+            queuedTasks.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::pin(const std::vector<int>& cpus) {
+    for (size_t i = 0; i < workers.size() && !cpus.empty(); ++i) {
+        const int cpu = cpus[i % cpus.size()];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(workers[i].native_handle(), sizeof(set), &set) != 0) {
+            throw std::runtime_error("No se pudo fijar el worker " + std::to_string(i) +
+                                     " a la CPU " + std::to_string(cpu));
+        }
+    }
+}
+
 void ThreadPool::wait() {
-    std::unique_lock<std::mutex> lock(queueMutex);
-    finished.wait(lock, [this] {
-        return tasks.empty() && (activeTasks.load(std::memory_order_relaxed) == 0);
+    std::unique_lock<std::mutex> lock(doneMutex);
+    allDone.wait(lock, [this] {
+        return pendingTasks.load(std::memory_order_acquire) == 0;
     });
 }
 
 ThreadPool::~ThreadPool() {
     {
-        std::unique_lock<std::mutex> lock(queueMutex);
+        std::lock_guard<std::mutex> lock(sleepMutex);
         stop.store(true, std::memory_order_relaxed);
     }
-    condition.notify_all();
+    wakeUp.notify_all();
     for (std::thread &worker : workers) {
         if (worker.joinable())
             worker.join();
@@ -0,0 +1,153 @@
+// src/topology.cpp
+#include "Topology.h"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sched.h>
+#include <stdexcept>
+
+namespace {
+
+// CPUs en las que puede correr el proceso (taskset, cgroups)
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        cpus.push_back(0);
+    }
+    return cpus;
+}
+
+int parseInt(std::string_view text, std::string_view list) {
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size() || value < 0) {
+        throw std::runtime_error("Lista de CPUs inválida: '" + std::string(list) + "'");
+    }
+    return value;
+}
+
+} // namespace
+
+std::vector<int> Topology::parseCpuList(std::string_view list) {
+    std::vector<int> cpus;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string_view::npos) {
+            comma = list.size();
+        }
+        std::string_view item = list.substr(start, comma - start);
+        while (!item.empty() && (item.back() == '\n' || item.back() == ' ')) {
+            item.remove_suffix(1);
+        }
+        if (!item.empty()) {
+            const size_t dash = item.find('-');
+            const int first = parseInt(item.substr(0, dash), list);
+            const int last = dash == std::string_view::npos ? first : parseInt(item.substr(dash + 1), list);
+            if (last < first) {
+                throw std::runtime_error("Lista de CPUs inválida: '" + std::string(list) + "'");
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        start = comma + 1;
+    }
+    return cpus;
+}
+
+Topology::Topology(const std::string& sysfsRoot) {
+    const std::vector<int> allowed = allowedCpus();
+    nodeOfCpu.assign(allowed.back() + 1, -1);
+
+    // nodeN/cpulist, ordenados por N
+    std::map<int, std::vector<int>> found;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(sysfsRoot, error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(file, list)) {
+            continue;
+        }
+        std::vector<int> cpus;
+        for (int cpu : parseCpuList(list)) {
+            if (std::binary_search(allowed.begin(), allowed.end(), cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (!cpus.empty()) {
+            found[std::stoi(name.substr(4))] = std::move(cpus);
+        }
+    }
+
+    for (auto& [number, cpus] : found) {
+        nodes.push_back(std::move(cpus));
+    }
+    if (nodes.empty()) {
+        nodes.push_back(allowed);
+    }
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        for (int cpu : nodes[node]) {
+            nodeOfCpu[cpu] = static_cast<int>(node);
+        }
+    }
+}
+
+int Topology::nodeOf(int cpu) const {
+    return cpu >= 0 && static_cast<size_t>(cpu) < nodeOfCpu.size() ? nodeOfCpu[cpu] : -1;
+}
+
+std::vector<int> Topology::placement(std::string_view spec, size_t numWorkers) const {
+    std::vector<int> order;
+    if (spec == "compact") {
+        for (const auto& cpus : nodes) {
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+    } else if (spec == "scatter") {
+        // Una CPU de cada nodo por vuelta
+        for (size_t k = 0; order.size() < nodeOfCpu.size(); ++k) {
+            bool any = false;
+            for (const auto& cpus : nodes) {
+                if (k < cpus.size()) {
+                    order.push_back(cpus[k]);
+                    any = true;
+                }
+            }
+            if (!any) {
+                break;
+            }
+        }
+    } else {
+        order = parseCpuList(spec);
+        for (int cpu : order) {
+            if (nodeOf(cpu) < 0) {
+                throw std::runtime_error("La CPU " + std::to_string(cpu) + " no está disponible");
+            }
+        }
+    }
+    if (order.empty()) {
+        throw std::runtime_error("Afinidad sin CPUs: '" + std::string(spec) + "'");
+    }
+
+    std::vector<int> result(numWorkers);
+    for (size_t w = 0; w < numWorkers; ++w) {
+        result[w] = order[w % order.size()];
+    }
+    return result;
+}
@@ -0,0 +1,138 @@
+// src/trajectoryReader.cpp
+#include "TrajectoryReader.h"
+#include "XyzParser.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+bool isBlankLine(std::string_view line) {
+    return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+} // namespace
+
+TrajectoryReader::TrajectoryReader(const std::string& filename_, Kind kind_, ElementMask keep_)
+    : filename(filename_), kind(kind_), keep(keep_),
+      input(openInput(filename_, true)), buffer(chunkSize),
+      dataBegin(0), dataEnd(0), eof(false), lineNumber(0), totalBytes(0) {}
+
+// Lee otro bloque del archivo; si el buffer está lleno con un frame
+// incompleto, lo agranda
+bool TrajectoryReader::fill() {
+    if (eof) {
+        return false;
+    }
+    if (dataBegin > 0) {
+        std::memmove(buffer.data(), buffer.data() + dataBegin, dataEnd - dataBegin);
+        dataEnd -= dataBegin;
+        dataBegin = 0;
+    }
+    if (buffer.size() - dataEnd < chunkSize / 2) {
+        buffer.resize(std::max(buffer.size() * 2, dataEnd + chunkSize));
+    }
+
+    size_t n = input->read(buffer.data() + dataEnd, buffer.size() - dataEnd);
+    if (n == 0) {
+        eof = true;
+        return false;
+    }
+    dataEnd += n;
+    totalBytes += n;
+    return true;
+}
+
+// Fin del frame que comienza en begin, o nullptr si el buffer todavía no
+// lo contiene entero. Sigue las mismas reglas que XyzParser: encabezado con
+// la cantidad de átomos, una línea de comentario (opcional en los archivos
+// de aguas) y un registro no vacío por átomo.
+const char* TrajectoryReader::findFrameEnd(const char* begin, const char* end) const {
+    const char* p = begin;
+    auto nextLine = [&](std::string_view& line) {
+        if (p == end) {
+            return false;
+        }
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!newline) {
+            if (!eof) {
+                return false;
+            }
+            newline = end;
+        }
+        line = std::string_view(p, newline - p);
+        p = newline == end ? end : newline + 1;
+        return true;
+    };
+
+    std::string_view line;
+    do {
+        if (!nextLine(line)) return eof ? end : nullptr;
+    } while (isBlankLine(line));
+
+    const size_t first = line.find_first_not_of(" \t\r");
+    const size_t last = line.find_first_of(" \t\r", first);
+    std::string_view token = line.substr(first, last == std::string_view::npos ? last : last - first);
+    size_t count = 0;
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), count);
+    if (ec != std::errc() || ptr != token.data() + token.size()) {
+        return p;  // El parser reporta el encabezado inválido
+    }
+
+    size_t records = 0;
+    bool firstLine = true;
+    if (kind == Kind::Protein) {
+        if (!nextLine(line)) return eof ? end : nullptr;
+        firstLine = false;
+    }
+    while (records < count) {
+        if (!nextLine(line)) return eof ? end : nullptr;
+        const bool comment = firstLine && !isBlankLine(line) && !XyzParser::isWaterRecord(line);
+        firstLine = false;
+        if (!comment && !isBlankLine(line)) {
+            ++records;
+        }
+    }
+    return p;
+}
+
+bool TrajectoryReader::readFrame(FrameData& frame) {
+    const char* frameEnd;
+    while (true) {
+        const char* begin = buffer.data() + dataBegin;
+        const char* end = buffer.data() + dataEnd;
+        if (std::all_of(begin, end, [](char c) { return std::isspace(static_cast<unsigned char>(c)); })) {
+            // Sólo espacio en blanco: descartarlo y leer más
+            lineNumber += std::count(begin, end, '\n');
+            dataBegin = dataEnd;
+            if (!fill()) {
+                return false;
+            }
+            continue;
+        }
+        frameEnd = findFrameEnd(begin, end);
+        if (frameEnd || !fill()) {
+            break;
+        }
+    }
+
+    const char* begin = buffer.data() + dataBegin;
+    if (!frameEnd) {
+        frameEnd = buffer.data() + dataEnd;
+    }
+
+    XyzParser parser(begin, frameEnd, filename, lineNumber);
+    if (kind == Kind::Protein) {
+        parser.parseProteinFrame(frame, keep);
+    } else {
+        parser.parseWaterFrame(frame, keep);
+    }
+    lastCommentFrame = parser.commentFrameNumber();
+
+    lineNumber += std::count(begin, frameEnd, '\n');
+    dataBegin = frameEnd - buffer.data();
+    return true;
+}
@@ -0,0 +1,80 @@
+// src/types.cpp
+#include "Types.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// Los nombres se escriben antes de publicar la nueva cantidad, así los
+// lectores sin lock sólo ven entradas completas
+std::array<std::string, ElementTable::maxElements> elementNames;
+std::atomic<size_t> elementCount{0};
+std::mutex elementMutex;
+
+} // namespace
+
+ElementId ElementTable::intern(std::string_view name) {
+    size_t n = elementCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+        if (elementNames[i] == name) {
+            return static_cast<ElementId>(i);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(elementMutex);
+    const size_t known = n;
+    n = elementCount.load(std::memory_order_relaxed);
+    for (size_t i = known; i < n; ++i) {
+        if (elementNames[i] == name) {
+            return static_cast<ElementId>(i);
+        }
+    }
+    if (n == maxElements) {
+        throw std::runtime_error("Demasiados elementos distintos: " + std::string(name));
+    }
+    elementNames[n].assign(name);
+    elementCount.store(n + 1, std::memory_order_release);
+    return static_cast<ElementId>(n);
+}
+
+const std::string& ElementTable::name(ElementId id) {
+    return elementNames[id];
+}
+
+size_t ElementTable::size() {
+    return elementCount.load(std::memory_order_acquire);
+}
+
+ElementMask ElementMask::all() {
+    ElementMask mask;
+    mask.bits.set();
+    return mask;
+}
+
+ElementMask ElementMask::parse(std::string_view spec) {
+    if (spec == "all") {
+        return all();
+    }
+    if (spec == "heavy") {
+        ElementMask mask = all();
+        mask.bits.reset(ElementTable::intern("H"));
+        return mask;
+    }
+
+    ElementMask mask;
+    while (!spec.empty()) {
+        const size_t comma = spec.find(',');
+        std::string_view name = spec.substr(0, comma);
+        if (name.empty()) {
+            throw std::runtime_error("Selección de elementos inválida: " + std::string(spec));
+        }
+        mask.bits.set(ElementTable::intern(name));
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+    }
+    if (mask.bits.none()) {
+        throw std::runtime_error("Selección de elementos vacía");
+    }
+    return mask;
+}
@@ -0,0 +1,142 @@
+// src/verletList.cpp
+#include "VerletList.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+VerletList::VerletList(double skin_)
+    : skin(skin_), valid(false), box(0, 0, 0), atomShift(0.0),
+      kernel(distanceKernel(box.kind)), reusedWaters(0), searchedWaters(0) {}
+
+// Desplazamiento con imagen mínima (las coordenadas pueden haber sido
+// reenvueltas en la caja entre frames)
+double VerletList::displacement(double x, double y, double z,
+                                double x0, double y0, double z0) const {
+    double dx = x - x0;
+    double dy = y - y0;
+    double dz = z - z0;
+    box.minimumImage(dx, dy, dz);
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+}
+
+size_t VerletList::beginFrame(const PositionsView& atoms, const PeriodicBox& box_,
+                              const double* wx, const double* wy, const double* wz,
+                              size_t numWaters) {
+    const double halfSkin = 0.5 * skin;
+
+    if (valid && (!(box_ == box) || atoms.size() != atomX0.size() || numWaters != waters.size())) {
+        valid = false;
+    }
+
+    if (valid) {
+        atomShift = 0.0;
+        for (size_t i = 0; i < atoms.size(); ++i) {
+            atomShift = std::max(atomShift, displacement(atoms.x[i], atoms.y[i], atoms.z[i],
+                                                         atomX0[i], atomY0[i], atomZ0[i]));
+        }
+        valid = atomShift <= halfSkin;
+    }
+
+    if (!valid) {
+        box = box_;
+        kernel = distanceKernel(box.kind);
+        atomX0.assign(atoms.x.begin(), atoms.x.end());
+        atomY0.assign(atoms.y.begin(), atoms.y.end());
+        atomZ0.assign(atoms.z.begin(), atoms.z.end());
+        atomShift = 0.0;
+        waters.assign(numWaters, WaterEntry{});
+        needsSearch.assign(numWaters, 1);
+        valid = true;
+        return numWaters;
+    }
+
+    // El átomo más cercano sigue entre los candidatos mientras el agua y la
+    // proteína, juntas, no se hayan movido más de skin/2 desde que se armó
+    // su lista
+    size_t count = 0;
+    for (size_t w = 0; w < numWaters; ++w) {
+        const WaterEntry& entry = waters[w];
+        const double moved = displacement(wx[w], wy[w], wz[w], entry.x0, entry.y0, entry.z0);
+        needsSearch[w] = moved + atomShift + entry.atomShift0 > halfSkin;
+        count += needsSearch[w];
+    }
+    return count;
+}
+
+void VerletList::findMinDistances(const PositionsView& atoms, const CellList<double>* cells,
+                                  const double* wx, const double* wy, const double* wz,
+                                  size_t begin, size_t end, double maxDistance, double* minDist) {
+    thread_local std::vector<size_t> search;
+    thread_local std::vector<double> sx, sy, sz, sd;
+    thread_local std::vector<double> cx, cy, cz;
+    search.clear();
+
+    size_t reused = 0;
+    for (size_t w = begin; w < end; ++w) {
+        if (needsSearch[w]) {
+            search.push_back(w);
+            continue;
+        }
+
+        // Sigue a más de maxDistance + skin/2: fuera del histograma
+        if (waters[w].far) {
+            minDist[w - begin] = std::numeric_limits<double>::max();
+            ++reused;
+            continue;
+        }
+
+        // Sólo los candidatos, con el mismo núcleo que la búsqueda completa
+        const std::vector<int>& candidates = waters[w].candidates;
+        cx.resize(candidates.size());
+        cy.resize(candidates.size());
+        cz.resize(candidates.size());
+        for (size_t k = 0; k < candidates.size(); ++k) {
+            cx[k] = atoms.x[candidates[k]];
+            cy[k] = atoms.y[candidates[k]];
+            cz[k] = atoms.z[candidates[k]];
+        }
+        double best2 = std::numeric_limits<double>::max();
+        if (!candidates.empty()) {
+            kernel(cx.data(), cy.data(), cz.data(), candidates.size(),
+                   wx + w, wy + w, wz + w, 1, box, &best2);
+        }
+        minDist[w - begin] = std::sqrt(best2);
+        ++reused;
+    }
+
+    if (!search.empty()) {
+        // Búsqueda completa de las aguas que salieron de su región y nueva
+        // lista de candidatos para cada una. Hasta maxDistance + skin la
+        // distancia es exacta; más allá el agua queda marcada como lejana.
+        sx.resize(search.size());
+        sy.resize(search.size());
+        sz.resize(search.size());
+        sd.resize(search.size());
+        for (size_t k = 0; k < search.size(); ++k) {
+            sx[k] = wx[search[k]];
+            sy[k] = wy[search[k]];
+            sz[k] = wz[search[k]];
+        }
+        const double reach = maxDistance + skin;
+        cells->findMinDistances(sx.data(), sy.data(), sz.data(), search.size(),
+                                reach, sd.data());
+
+        for (size_t k = 0; k < search.size(); ++k) {
+            const size_t w = search[k];
+            WaterEntry& entry = waters[w];
+            entry.x0 = sx[k];
+            entry.y0 = sy[k];
+            entry.z0 = sz[k];
+            entry.atomShift0 = atomShift;
+            entry.far = sd[k] > reach;
+            entry.candidates.clear();
+            if (!entry.far) {
+                cells->findNeighbors(sx[k], sy[k], sz[k], sd[k] + skin, entry.candidates);
+            }
+            minDist[w - begin] = sd[k];
+        }
+    }
+
+    reusedWaters += reused;
+    searchedWaters += search.size();
+}
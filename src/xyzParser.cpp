@@ -0,0 +1,308 @@
+// src/xyzParser.cpp
+#include "XyzParser.h"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr const char* commentRule =
+    " (una línea de comentario de aguas debe tener un campo clave=valor o no comenzar"
+    " con un nombre de elemento seguido de siete números)";
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Extrae el siguiente token separado por espacios de rest
+bool nextToken(std::string_view& rest, std::string_view& token) {
+    size_t i = 0;
+    while (i < rest.size() && isBlank(rest[i])) ++i;
+    if (i == rest.size()) {
+        rest = {};
+        return false;
+    }
+    size_t j = i;
+    while (j < rest.size() && !isBlank(rest[j])) ++j;
+    token = rest.substr(i, j - i);
+    rest.remove_prefix(j);
+    return true;
+}
+
+bool parseDouble(std::string_view token, double& value) {
+    // from_chars no acepta el signo '+'
+    if (!token.empty() && token.front() == '+') {
+        token.remove_prefix(1);
+    }
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+    return ec == std::errc() && ptr == token.data() + token.size();
+}
+
+// Lee "elemento v0 v1 ... vN-1"; los campos adicionales se ignoran
+template <size_t N>
+bool parseRecord(std::string_view line, std::string_view& element, double (&values)[N]) {
+    if (!nextToken(line, element)) {
+        return false;
+    }
+    std::string_view token;
+    for (size_t k = 0; k < N; ++k) {
+        if (!nextToken(line, token) || !parseDouble(token, values[k])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Nombre de elemento o de átomo: letras, dígitos y '_', comenzando por letra
+bool isElementName(std::string_view token) {
+    auto isAlpha = [](char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); };
+    return !token.empty() && isAlpha(token.front()) &&
+           std::all_of(token.begin(), token.end(), [&](char c) {
+               return isAlpha(c) || (c >= '0' && c <= '9') || c == '_';
+           });
+}
+
+} // namespace
+
+XyzParser::XyzParser(const char* begin, const char* end_, std::string source_, size_t firstLine)
+    : pos(begin), end(end_), source(std::move(source_)), lineNumber(firstLine),
+      lastElementId(0), waterCount(0), watersRead(0), waterHeaderLine(0) {}
+
+bool XyzParser::isWaterRecord(std::string_view line) {
+    // Un campo clave=valor (Lattice="30.0 0 0 ...", frame=3) sólo puede
+    // estar en un comentario, aunque lo sigan siete números
+    if (line.find_first_of("=\"") != std::string_view::npos) {
+        return false;
+    }
+    std::string_view element;
+    double v[7];
+    return parseRecord(line, element, v) && isElementName(element);
+}
+
+// Interpreta los campos clave=valor de la línea de comentario: Lx=, Ly=,
+// Lz=, los factores de inclinación xy=, xz=, yz= o la celda de XYZ
+// extendido Lattice="ax ay az bx by bz cx cy cz" (sólo si frame no es
+// nulo) y frame=
+void XyzParser::parseComment(std::string_view line, FrameData* frame) {
+    const char* lineEnd = line.data() + line.size();
+    std::string_view token;
+    while (nextToken(line, token)) {
+        if (token.starts_with("frame=")) {
+            int number = 0;
+            std::string_view value = token.substr(6);
+            auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+            if (ec != std::errc() || ptr != value.data() + value.size()) {
+                fail("número de frame inválido: '" + std::string(token) + "'");
+            }
+            commentFrame = number;
+            continue;
+        }
+        if (token.starts_with("Lattice=\"")) {
+            // El valor entre comillas contiene espacios
+            const char* begin = token.data() + 9;
+            const char* close = std::find(begin, lineEnd, '"');
+            if (close == lineEnd) {
+                fail("celda sin comillas de cierre: '" + std::string(token) + "'");
+            }
+            line = std::string_view(close + 1, lineEnd - close - 1);
+            if (frame) {
+                parseLattice(std::string_view(begin, close - begin), *frame);
+            }
+            continue;
+        }
+        if (!frame) {
+            continue;
+        }
+        double* target = nullptr;
+        if (token.starts_with("Lx=")) target = &frame->Lx;
+        else if (token.starts_with("Ly=")) target = &frame->Ly;
+        else if (token.starts_with("Lz=")) target = &frame->Lz;
+        else if (token.starts_with("xy=")) target = &frame->xy;
+        else if (token.starts_with("xz=")) target = &frame->xz;
+        else if (token.starts_with("yz=")) target = &frame->yz;
+        if (target && !parseDouble(token.substr(3), *target)) {
+            fail("dimensión de caja inválida: '" + std::string(token) + "'");
+        }
+    }
+}
+
+// Los vectores de la celda deben tener la forma a = (Lx, 0, 0),
+// b = (xy, Ly, 0), c = (xz, yz, Lz), la misma que usa la imagen mínima
+void XyzParser::parseLattice(std::string_view value, FrameData& frame) {
+    double v[9];
+    std::string_view token;
+    for (double& component : v) {
+        if (!nextToken(value, token) || !parseDouble(token, component)) {
+            fail("celda inválida: se esperaban 9 números en Lattice");
+        }
+    }
+    if (v[1] != 0 || v[2] != 0 || v[5] != 0) {
+        fail("celda no soportada: a debe ser (Lx, 0, 0) y b (xy, Ly, 0)");
+    }
+    frame.Lx = v[0];
+    frame.xy = v[3];
+    frame.Ly = v[4];
+    frame.xz = v[6];
+    frame.yz = v[7];
+    frame.Lz = v[8];
+}
+
+// Los registros consecutivos suelen repetir el elemento: se compara primero
+// con el último antes de ir a la tabla compartida
+ElementId XyzParser::internElement(std::string_view name) {
+    if (name != lastElement) {
+        lastElementId = ElementTable::intern(name);
+        lastElement = name;
+    }
+    return lastElementId;
+}
+
+void XyzParser::fail(const std::string& message) const {
+    throw std::runtime_error(source + ":" + std::to_string(lineNumber) + ": " + message);
+}
+
+bool XyzParser::nextLine(std::string_view& line) {
+    if (pos == end) {
+        return false;
+    }
+    const char* start = pos;
+    while (pos != end && *pos != '\n') ++pos;
+    line = std::string_view(start, pos - start);
+    if (pos != end) ++pos;
+    ++lineNumber;
+    return true;
+}
+
+bool XyzParser::nextNonBlankLine(std::string_view& line) {
+    while (nextLine(line)) {
+        std::string_view rest = line, token;
+        if (nextToken(rest, token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool XyzParser::atEnd() {
+    while (pos != end && (isBlank(*pos) || *pos == '\n')) {
+        if (*pos == '\n') ++lineNumber;
+        ++pos;
+    }
+    return pos == end;
+}
+
+size_t XyzParser::parseCount() {
+    std::string_view line, token;
+    if (!nextNonBlankLine(line)) {
+        fail("archivo vacío o truncado");
+    }
+    const std::string_view header = line;
+    nextToken(line, token);
+    size_t count = 0;
+    auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), count);
+    if (ec != std::errc() || ptr != token.data() + token.size()) {
+        // En una trayectoria, un registro en lugar del encabezado suele ser
+        // el último del frame anterior, corrido por un comentario ambiguo
+        fail("número de átomos inválido: '" + std::string(token) + "'" +
+             (isWaterRecord(header) ? commentRule : ""));
+    }
+    return count;
+}
+
+void XyzParser::parseProteinFrame(FrameData& frame, const ElementMask& keep) {
+    const size_t numAtoms = parseCount();
+    commentFrame.reset();
+    frame.Lx = frame.Ly = frame.Lz = 0;
+    frame.xy = frame.xz = frame.yz = 0;
+
+    // Línea de dimensiones de la caja
+    std::string_view line;
+    if (!nextLine(line)) {
+        fail("falta la línea de dimensiones");
+    }
+    parseComment(line, &frame);
+
+    // Leer átomos; los que no están en keep no se guardan
+    ProteinAtoms& atoms = frame.proteinAtoms;
+    atoms.resize(numAtoms);
+    size_t stored = 0;
+    for (size_t i = 0; i < numAtoms; ++i) {
+        if (!nextNonBlankLine(line)) {
+            fail("se esperaban " + std::to_string(numAtoms) + " átomos, se encontraron " +
+                 std::to_string(i));
+        }
+        std::string_view element;
+        double v[3];
+        if (!parseRecord(line, element, v)) {
+            fail("línea de átomo mal formada: '" + std::string(line) + "'");
+        }
+        const ElementId id = internElement(element);
+        if (!keep.contains(id)) {
+            continue;
+        }
+        atoms.element[stored] = id;
+        atoms.x[stored] = v[0];
+        atoms.y[stored] = v[1];
+        atoms.z[stored] = v[2];
+        ++stored;
+    }
+    atoms.resize(stored);
+}
+
+void XyzParser::parseWaterFrame(FrameData& frame, const ElementMask& keep) {
+    beginWaterFrame();
+    nextWaters(frame.waterMolecules, waterCount, keep);
+}
+
+void XyzParser::beginWaterFrame() {
+    waterCount = parseCount();
+    watersRead = 0;
+    waterHeaderLine = lineNumber;
+    commentFrame.reset();
+}
+
+bool XyzParser::nextWaters(WaterMolecules& waters, size_t maxMolecules, const ElementMask& keep) {
+    // Leer moléculas de agua
+    waters.resize(std::min(maxMolecules, waterCount - watersRead));
+    std::string_view line;
+    size_t stored = 0;
+    while (watersRead < waterCount && stored < maxMolecules) {
+        if (!nextNonBlankLine(line)) {
+            fail("se esperaban " + std::to_string(waterCount) + " moléculas, se encontraron " +
+                 std::to_string(watersRead));
+        }
+        // La línea siguiente al encabezado es un comentario si no es un
+        // registro (con la misma regla que TrajectoryReader::findFrameEnd)
+        if (watersRead == 0 && lineNumber == waterHeaderLine + 1 && !isWaterRecord(line)) {
+            parseComment(line, nullptr);
+            continue;
+        }
+        std::string_view element;
+        double v[7];
+        if (!parseRecord(line, element, v)) {
+            fail("línea de agua mal formada: '" + std::string(line) + "'");
+        }
+        ++watersRead;
+        const ElementId id = internElement(element);
+        if (!keep.contains(id)) {
+            continue;
+        }
+        waters.element[stored] = id;
+        waters.x[stored] = v[0];
+        waters.y[stored] = v[1];
+        waters.z[stored] = v[2];
+        waters.Q4[stored] = v[3];
+        waters.Q6[stored] = v[4];
+        waters.W4[stored] = v[5];
+        waters.W6[stored] = v[6];
+        ++stored;
+    }
+    // El frame termina con su último registro: si queda otro, la línea
+    // siguiente al encabezado se tomó como molécula y era un comentario
+    if (watersRead == waterCount && !atEnd()) {
+        fail("hay más moléculas que las " + std::to_string(waterCount) + " del encabezado" + commentRule);
+    }
+    waters.resize(stored);
+    return stored > 0;
+}